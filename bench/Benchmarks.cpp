@@ -0,0 +1,773 @@
+/**
+ *
+ * Benchmarks.cpp
+ *
+ * Copyright (c) 2021-2025, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#include "CorpusGen.hpp"
+#include "SARC.hpp"
+#include "ACNHSarc.hpp"
+#include "BCSV.hpp"
+#include "BCSVIndex.hpp"
+#include "Byaml.hpp"
+#include "ACNHByaml.hpp"
+#include "ByamlQuery.hpp"
+#include "ByamlWriter.hpp"
+#include "ByamlYaml.hpp"
+#include "ByamlPatch.hpp"
+#include "MSBT.hpp"
+#include "CRC32.hpp"
+#include "MurmurHash3.hpp"
+#include "SeadRandom.hpp"
+#include "SaveCrypto.hpp"
+#include "BFTTF.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+static const constexpr u32 SARCFileCount = 2000;
+static const constexpr u32 SARCFileSize = 0x400;
+static const constexpr u32 BCSVRowCount = 10000;
+static const constexpr u32 ByamlTypeCount = 64;
+static const constexpr u32 ByamlMemberCount = 32;
+static const constexpr u32 ByamlTreeDepth = 4;
+static const constexpr u32 ByamlTreeFanOut = 8;
+static const constexpr u32 ByamlSharedDepth = 64;
+static const constexpr u32 MSBTEntryCount = 5000;
+static const constexpr u32 BFTTFSize = 0x100000;
+static const constexpr u32 HashBufferSize = 0x100000;
+
+struct BenchFiles {
+    std::string directory;
+    std::string sarcPath;
+    std::string sarcZsPath;
+    std::string bfttfPath;
+    std::string ttfPath;
+    std::string bcsvIndexPath;
+
+    std::vector<u8> sarc;
+    std::vector<u8> sarcBE;
+    std::vector<u8> bcsv;
+    std::vector<u8> byaml;
+    std::vector<u8> byamlBE;
+    std::vector<u8> byamlTree;
+    std::vector<u8> byamlTreeBE;
+    std::vector<u8> byamlShared;
+    std::vector<u8> byamlScalars;
+    std::vector<u8> msbt;
+    std::vector<u8> hashBuffer;
+    std::vector<std::string> sarcNames;
+};
+
+static BenchFiles files;
+
+static std::vector<u8> MakeSharedByaml(u32 depth) { //Each hash holds its child twice, ByamlWriter writes every level once
+    ByamlWriter writer;
+    u32 child = writer.AddInt(0);
+    for (u32 i = 0; i < depth; i++) {
+        u32 hash = writer.AddHash();
+        writer.Set(hash, "a", child);
+        writer.Set(hash, "b", child);
+        child = hash;
+    }
+    writer.SetRoot(child);
+
+    std::vector<u8> out(writer.GetSize());
+    writer.WriteTo(out.data(), out.size());
+    return out;
+}
+
+static std::vector<u8> MakeScalarByaml() { //Values and keys the YAML emitter has to quote, tag or format exactly
+    static const char* const Strings[] = { "", " ", "plain", "two words", "yes", "Off", "y", "NULL", "~", "TrUe", "0o17", "0x1F", "017",
+        "1_000", "1:30", ".5", "1e5", "+1", "-1", ".nan", "NaN", "-.inf", "Infinity", "a: b", "a #b", "#c", "- d", "[e]", "{f}", "g,h",
+        "'i'", "\"j\"", "k\\l", "m\n\tn\r", "\x01\x7F", "trailing ", "colon:", "&anchor", "*alias", "!tag", "|", ">", "%", "@", "`",
+        "\xE3\x81\x82" };
+
+    ByamlWriter writer(4);
+    u32 strings = writer.AddArray();
+    u32 keys = writer.AddHash();
+    for (const char* str : Strings) {
+        writer.Append(strings, writer.AddString(str));
+        if (str[0] != '\0')
+            writer.Set(keys, str, writer.AddNull());
+    }
+
+    u32 numbers = writer.AddArray();
+    static const float Floats[] = { 0.0f, -0.0f, 1.0f, 0.1f, -1.5e-45f, 1.17549435e-38f, 3.40282347e38f, 16777217.0f, INFINITY, -INFINITY, NAN };
+    static const double Doubles[] = { 0.0, -0.0, 0.1, 1e300, 4.9e-324, 9007199254740993.0, INFINITY, NAN };
+    for (float value : Floats)
+        writer.Append(numbers, writer.AddFloat(value));
+    for (double value : Doubles)
+        writer.Append(numbers, writer.AddDouble(value));
+    for (s32 value : { 0, -1, 0x7FFFFFFF, -0x7FFFFFFF - 1 })
+        writer.Append(numbers, writer.AddInt(value));
+    for (u32 value : { 0u, 1u, 0xFFFFFFFFu })
+        writer.Append(numbers, writer.AddUInt(value));
+    for (s64 value : { static_cast<s64>(0), static_cast<s64>(-1), INT64_MAX, INT64_MIN })
+        writer.Append(numbers, writer.AddInt64(value));
+    for (u64 value : { static_cast<u64>(0), UINT64_MAX })
+        writer.Append(numbers, writer.AddUInt64(value));
+    writer.Append(numbers, writer.AddBool(true));
+    writer.Append(numbers, writer.AddBool(false));
+    writer.Append(numbers, writer.AddNull());
+
+    static const u8 Binary[] = { 0x00, 0xFF, 0x10, 0x80, 0x7F };
+    u32 root = writer.AddHash();
+    writer.Set(root, "strings", strings);
+    writer.Set(root, "keys", keys);
+    writer.Set(root, "numbers", numbers);
+    writer.Set(root, "empty array", writer.AddArray());
+    writer.Set(root, "empty hash", writer.AddHash());
+    for (u32 size = 0; size <= sizeof(Binary); size++)
+        writer.Set(root, ("binary" + std::to_string(size)).c_str(), writer.AddBinary(Binary, size));
+    writer.SetRoot(root);
+
+    std::vector<u8> out(writer.GetSize());
+    writer.WriteTo(out.data(), out.size());
+    return out;
+}
+
+//Byaml -> YAML -> Byaml -> YAML, the two texts must match
+static bool YamlRoundTrips(std::vector<u8>& file, u16 version) {
+    Byaml byaml(file.data(), file.size(), false, false);
+    std::string yaml, again;
+    if (!byaml.IsValid() || !byaml.ToString(yaml))
+        return false;
+
+    ByamlYamlParser parser(version);
+    if (!parser.ParseString(yaml.data(), yaml.size()))
+        return false;
+
+    std::vector<u8> written(parser.GetWriter().GetSize());
+    if (written.empty() || !parser.GetWriter().WriteTo(written.data(), written.size()))
+        return false;
+
+    Byaml reread(written.data(), written.size(), false, false);
+    return reread.IsValid() && reread.ToString(again) && again == yaml;
+}
+
+static bool SetupFiles() {
+    char dirTemplate[] = "/tmp/libacnh_bench_XXXXXX";
+    if (mkdtemp(dirTemplate) == nullptr)
+        return false;
+
+    files.directory = dirTemplate;
+    files.sarcPath = files.directory + "/bench.sarc";
+    files.sarcZsPath = files.directory + "/bench.sarc.zs";
+    files.bfttfPath = files.directory + "/bench.bfttf";
+    files.ttfPath = files.directory + "/bench.ttf";
+    files.bcsvIndexPath = files.directory + "/bench.bcsvidx";
+
+    SARCGenParams sarcParams;
+    sarcParams.fileCount = SARCFileCount;
+    sarcParams.fileSize = SARCFileSize;
+    files.sarc = CorpusGen::MakeSARC(sarcParams);
+    sarcParams.bigEndian = true;
+    files.sarcBE = CorpusGen::MakeSARC(sarcParams);
+
+    BCSVGenParams bcsvParams;
+    bcsvParams.rowCount = BCSVRowCount;
+    files.bcsv = CorpusGen::MakeBCSV(bcsvParams);
+
+    ByamlGenParams byamlParams;
+    byamlParams.depth = ByamlTreeDepth;
+    byamlParams.fanOut = ByamlTreeFanOut;
+    files.byamlTree = CorpusGen::MakeByaml(byamlParams);
+    byamlParams.bigEndian = true;
+    files.byamlTreeBE = CorpusGen::MakeByaml(byamlParams);
+    files.byaml = CorpusGen::MakeSaveLayoutByaml(ByamlTypeCount, ByamlMemberCount);
+    files.byamlBE = CorpusGen::MakeSaveLayoutByaml(ByamlTypeCount, ByamlMemberCount, true);
+    files.byamlShared = MakeSharedByaml(ByamlSharedDepth);
+    files.byamlScalars = MakeScalarByaml();
+
+    MSBTGenParams msbtParams;
+    msbtParams.entryCount = MSBTEntryCount;
+    files.msbt = CorpusGen::MakeMSBT(msbtParams);
+
+    files.hashBuffer.resize(HashBufferSize);
+    for (u32 i = 0; i < HashBufferSize; i++)
+        files.hashBuffer[i] = static_cast<u8>(i * 7);
+
+    for (u32 i = 0; i < SARCFileCount; i++)
+        files.sarcNames.push_back(CorpusGen::SARCFileName(i));
+
+    return CorpusGen::WriteFile(files.sarcPath, files.sarc) &&
+           CorpusGen::WriteFile(files.sarcZsPath, CorpusGen::MakeZstdFrame(files.sarc)) &&
+           CorpusGen::WriteFile(files.bfttfPath, CorpusGen::MakeBFTTF(BFTTFSize));
+}
+
+static void CleanupFiles() {
+    remove(files.sarcPath.c_str());
+    remove(files.sarcZsPath.c_str());
+    remove(files.bfttfPath.c_str());
+    remove(files.ttfPath.c_str());
+    remove(files.bcsvIndexPath.c_str());
+    rmdir(files.directory.c_str());
+}
+
+/* SARC */
+
+static void BM_SARC_Open(benchmark::State& state) { //Same archive in either byte order
+    bool bigEndian = state.range(0) != 0;
+    std::vector<u8>& file = bigEndian ? files.sarcBE : files.sarc;
+    SARC check(file.data(), file.size(), false);
+    if (!check.IsValid() || check.IsBigEndian() != bigEndian || check.GetFileCount() != SARCFileCount) {
+        state.SkipWithError("Archive didn't parse");
+        return;
+    }
+
+    for (auto _ : state) {
+        SARC sarc(file.data(), file.size(), false);
+        benchmark::DoNotOptimize(sarc.IsValid());
+    }
+    state.SetBytesProcessed(state.iterations() * file.size());
+}
+BENCHMARK(BM_SARC_Open)->ArgName("bigEndian")->Arg(0)->Arg(1);
+
+static void BM_SARC_OpenFile(benchmark::State& state) {
+    bool mapFile = state.range(0) != 0;
+    for (auto _ : state) {
+        SARC sarc(files.sarcPath.c_str(), mapFile);
+        benchmark::DoNotOptimize(sarc.IsValid());
+    }
+    state.SetBytesProcessed(state.iterations() * files.sarc.size());
+}
+BENCHMARK(BM_SARC_OpenFile)->ArgName("mapFile")->Arg(0)->Arg(1);
+
+static void BM_SARC_GetFileInfo(benchmark::State& state) {
+    SARC sarc(files.sarc.data(), files.sarc.size(), false);
+    SARCFileInfo info;
+    u32 i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sarc.GetFileInfo(info, files.sarcNames[i].c_str()));
+        i = (i + 1) % SARCFileCount;
+    }
+}
+BENCHMARK(BM_SARC_GetFileInfo);
+
+static void BM_SARC_GetFileInfoByHash(benchmark::State& state) {
+    SARC sarc(files.sarc.data(), files.sarc.size(), false);
+    std::vector<u32> hashes;
+    for (const auto& name : files.sarcNames)
+        hashes.push_back(SARC::CalcNameHash(name.c_str()));
+
+    SARCFileInfo info;
+    u32 i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sarc.GetFileInfoByHash(info, hashes[i]));
+        i = (i + 1) % SARCFileCount;
+    }
+}
+BENCHMARK(BM_SARC_GetFileInfoByHash);
+
+/* ACNHSarc */
+
+static void BM_ACNHSarc_Decompress(benchmark::State& state) {
+    for (auto _ : state) {
+        ACNHSarc sarc(files.sarcZsPath.c_str());
+        benchmark::DoNotOptimize(sarc.IsValid());
+    }
+    state.SetBytesProcessed(state.iterations() * files.sarc.size());
+}
+BENCHMARK(BM_ACNHSarc_Decompress);
+
+static void BM_ACNHSarc_LazyLookup(benchmark::State& state) {
+    SARCFileInfo info;
+    for (auto _ : state) {
+        ACNHSarc sarc(files.sarcZsPath.c_str(), true);
+        benchmark::DoNotOptimize(sarc.GetFileInfo(info, files.sarcNames[0].c_str()));
+    }
+}
+BENCHMARK(BM_ACNHSarc_LazyLookup);
+
+/* BCSV */
+
+static void BM_BCSV_Parse(benchmark::State& state) {
+    for (auto _ : state) {
+        BCSV bcsv(files.bcsv.data(), files.bcsv.size(), false);
+        benchmark::DoNotOptimize(bcsv.IsValid());
+    }
+    state.SetBytesProcessed(state.iterations() * files.bcsv.size());
+}
+BENCHMARK(BM_BCSV_Parse);
+
+static void BM_BCSV_Open(benchmark::State& state) { //Column directory only, no rows decoded
+    for (auto _ : state) {
+        BCSV bcsv(files.bcsv.data(), files.bcsv.size(), false, false);
+        benchmark::DoNotOptimize(bcsv.IsValid());
+    }
+}
+BENCHMARK(BM_BCSV_Open);
+
+static void BM_BCSV_OpenWithSchema(benchmark::State& state) { //Declared types, so no column is scanned for floats
+    BCSVSchema schema;
+    schema.Register("Weight", ColumnType::Float);
+    for (auto _ : state) {
+        BCSV bcsv(files.bcsv.data(), files.bcsv.size(), false, false, &schema);
+        benchmark::DoNotOptimize(bcsv.IsValid());
+    }
+}
+BENCHMARK(BM_BCSV_OpenWithSchema);
+
+static void BM_BCSV_GetColumnByHash(benchmark::State& state) {
+    BCSV bcsv(files.bcsv.data(), files.bcsv.size(), false);
+    std::vector<BCSVField> column;
+    u32 columnHash = CRC32::Calc("Price");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bcsv.GetColumnByHash(column, columnHash));
+    }
+    state.SetItemsProcessed(state.iterations() * BCSVRowCount);
+}
+BENCHMARK(BM_BCSV_GetColumnByHash);
+
+static void BM_BCSV_GetColumn(benchmark::State& state) { //Typed column scan
+    BCSV bcsv(files.bcsv.data(), files.bcsv.size(), false);
+    u32 columnHash = CRC32::Calc("Price");
+    for (auto _ : state) {
+        const u32* prices = nullptr;
+        u64 total = 0;
+        if (bcsv.GetColumn(columnHash, prices)) {
+            for (u32 i = 0; i < BCSVRowCount; i++)
+                total += prices[i];
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * BCSVRowCount);
+}
+BENCHMARK(BM_BCSV_GetColumn);
+
+static void BM_BCSV_Get(benchmark::State& state) { //Same scan, cells read in place from an unparsed table
+    BCSV bcsv(files.bcsv.data(), files.bcsv.size(), false, false);
+    u32 columnHash = CRC32::Calc("Price");
+    for (auto _ : state) {
+        const BCSVColumn* column = bcsv.GetColumnInfo(columnHash);
+        u64 total = 0;
+        for (u32 i = 0; column != nullptr && i < BCSVRowCount; i++) {
+            u32 price = 0;
+            bcsv.Get(i, *column, price);
+            total += price;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * BCSVRowCount);
+}
+BENCHMARK(BM_BCSV_Get);
+
+static void BM_BCSV_GetRow(benchmark::State& state) { //Copies each row into a BCSVRow map
+    BCSV bcsv(files.bcsv.data(), files.bcsv.size(), false);
+    u32 columnHash = CRC32::Calc("Price");
+    BCSVRow row;
+    for (auto _ : state) {
+        u64 total = 0;
+        for (u32 i = 0; i < BCSVRowCount; i++) {
+            bcsv.GetRow(row, i);
+            total += row[columnHash].UInt32;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * BCSVRowCount);
+}
+BENCHMARK(BM_BCSV_GetRow);
+
+static void BM_BCSV_RowView(benchmark::State& state) { //Same loop through non-owning row views
+    BCSV bcsv(files.bcsv.data(), files.bcsv.size(), false);
+    u32 columnHash = CRC32::Calc("Price");
+    for (auto _ : state) {
+        u64 total = 0;
+        for (u32 i = 0; i < BCSVRowCount; i++) {
+            u32 price = 0;
+            bcsv.GetRowView(i).Get(columnHash, price);
+            total += price;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * BCSVRowCount);
+}
+BENCHMARK(BM_BCSV_RowView);
+
+static void BM_BCSV_FindRowScan(benchmark::State& state) { //Baseline for BCSVIndex: row by unique ID without an index
+    BCSV bcsv(files.bcsv.data(), files.bcsv.size(), false);
+    const BCSVColumn* column = bcsv.GetColumnInfo(CRC32::Calc("UniqueID"));
+    u32 i = 0;
+    for (auto _ : state) {
+        u32 id = 0x1000 + ((i++ * 7919) % BCSVRowCount);
+        u32 row = 0;
+        for (u32 value = 0; row < BCSVRowCount && (!bcsv.Get(row, *column, value) || value != id); row++) {}
+        benchmark::DoNotOptimize(row);
+    }
+}
+BENCHMARK(BM_BCSV_FindRowScan);
+
+static void BM_BCSVIndex_Build(benchmark::State& state) {
+    BCSV bcsv(files.bcsv.data(), files.bcsv.size(), false, false);
+    u32 columnHash = CRC32::Calc(state.range(0) ? "Label" : "UniqueID");
+    for (auto _ : state) {
+        BCSVIndex index(bcsv);
+        benchmark::DoNotOptimize(index.Build(columnHash));
+    }
+    state.SetItemsProcessed(state.iterations() * BCSVRowCount);
+}
+BENCHMARK(BM_BCSVIndex_Build)->Arg(0)->Arg(1); //u32, string column
+
+static void BM_BCSVIndex_FindRow(benchmark::State& state) {
+    BCSV bcsv(files.bcsv.data(), files.bcsv.size(), false, false);
+    BCSVIndex index(bcsv);
+    u32 columnHash = CRC32::Calc("UniqueID");
+    u32 i = 0;
+    for (auto _ : state) {
+        u32 row = 0;
+        index.FindRow(columnHash, 0x1000 + ((i++ * 7919) % BCSVRowCount), row);
+        benchmark::DoNotOptimize(row);
+    }
+}
+BENCHMARK(BM_BCSVIndex_FindRow);
+
+static void BM_BCSVIndex_Load(benchmark::State& state) { //Cached indexes, instead of sorting again
+    BCSV bcsv(files.bcsv.data(), files.bcsv.size(), false, false);
+    {
+        BCSVIndex index(bcsv);
+        index.Build(CRC32::Calc("UniqueID"));
+        index.Build(CRC32::Calc("Label"));
+        if (!index.Save(files.bcsvIndexPath.c_str())) {
+            state.SkipWithError("Failed to save index cache");
+            return;
+        }
+    }
+
+    for (auto _ : state) {
+        BCSVIndex index(bcsv);
+        benchmark::DoNotOptimize(index.Load(files.bcsvIndexPath.c_str()));
+    }
+    state.SetItemsProcessed(state.iterations() * BCSVRowCount * 2);
+}
+BENCHMARK(BM_BCSVIndex_Load);
+
+/* Byaml */
+
+static void BM_Byaml_Parse(benchmark::State& state) {
+    for (auto _ : state) {
+        Byaml byaml(files.byaml.data(), files.byaml.size(), false);
+        benchmark::DoNotOptimize(byaml.IsValid());
+    }
+    state.SetBytesProcessed(state.iterations() * files.byaml.size());
+}
+BENCHMARK(BM_Byaml_Parse);
+
+static void BM_Byaml_ParseTree(benchmark::State& state) { //Same tree in either byte order
+    bool bigEndian = state.range(0) != 0;
+    std::vector<u8>& file = bigEndian ? files.byamlTreeBE : files.byamlTree;
+    Byaml check(file.data(), file.size(), false), little(files.byamlTree.data(), files.byamlTree.size(), false);
+    std::string yaml, littleYaml; //Values are decoded to host order, so both byte orders read the same
+    if (!check.IsValid() || check.IsBigEndian() != bigEndian || !check.ToString(yaml) || !little.ToString(littleYaml) || yaml != littleYaml) {
+        state.SkipWithError("Tree didn't parse");
+        return;
+    }
+
+    for (auto _ : state) {
+        Byaml byaml(file.data(), file.size(), false);
+        benchmark::DoNotOptimize(byaml.IsValid());
+    }
+    state.SetBytesProcessed(state.iterations() * file.size());
+}
+BENCHMARK(BM_Byaml_ParseTree)->ArgName("bigEndian")->Arg(0)->Arg(1);
+
+static void BM_Byaml_ParseShared(benchmark::State& state) { //2^64 paths through a few hundred bytes, shared containers must be parsed once
+    for (auto _ : state) {
+        Byaml byaml(files.byamlShared.data(), files.byamlShared.size(), false);
+        const ByamlNode& root = byaml.GetRootNode();
+        if (!byaml.IsValid() || root.type != NodeType::Hash || root.size != 2 || root.hash[0].node.hash != root.hash[1].node.hash) {
+            state.SkipWithError("Shared containers weren't parsed once");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * files.byamlShared.size());
+}
+BENCHMARK(BM_Byaml_ParseShared);
+
+static void BM_Byaml_Find(benchmark::State& state) {
+    Byaml byaml(files.byaml.data(), files.byaml.size(), false);
+    for (auto _ : state) {
+        std::vector<ByamlNode> nodes = byaml["a7bb2e42"]; //Offset
+        benchmark::DoNotOptimize(nodes.data());
+    }
+}
+BENCHMARK(BM_Byaml_Find);
+
+static void BM_Byaml_GetKey(benchmark::State& state) { //Keyed lookups on the parsed tree, key resolved once
+    Byaml byaml(files.byaml.data(), files.byaml.size(), false);
+    const ByamlNode& root = byaml.GetRootNode();
+    u32 membersKey = 0, offsetKey = 0;
+    byaml.GetKeyIndex("a2fb4a94", membersKey); //Members
+    byaml.GetKeyIndex("a7bb2e42", offsetKey); //Offset
+    for (auto _ : state) {
+        s64 total = 0;
+        for (u64 i = 0; i < root.size; i++) {
+            const ByamlNode* members = root.array[i].GetByKeyIndex(membersKey);
+            for (u64 j = 0; members != nullptr && j < members->size; j++)
+                total += members->array[j].GetByKeyIndex(offsetKey)->Int64;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+}
+BENCHMARK(BM_Byaml_GetKey);
+
+static void BM_ByamlView_Open(benchmark::State& state) {
+    for (auto _ : state) {
+        Byaml byaml(files.byaml.data(), files.byaml.size(), false, false);
+        benchmark::DoNotOptimize(byaml.GetRoot().GetSize());
+    }
+}
+BENCHMARK(BM_ByamlView_Open);
+
+static void BM_ByamlView_Lookup(benchmark::State& state) { //Open + one Offset lookup, nothing parsed
+    for (auto _ : state) {
+        Byaml byaml(files.byaml.data(), files.byaml.size(), false, false);
+        ByamlView type = byaml.GetRoot().At(byaml.GetRoot().GetSize() - 1);
+        ByamlView members = type.Get("a2fb4a94"); //Members
+        s64 offset = 0;
+        members.At(members.GetSize() - 1).Get("a7bb2e42").GetInt64(offset); //Offset
+        benchmark::DoNotOptimize(offset);
+    }
+}
+BENCHMARK(BM_ByamlView_Lookup);
+
+static void BM_ByamlPatch_Set(benchmark::State& state) { //Lookup + in-place write of one 64-bit value, in either byte order
+    std::vector<u8> data = state.range(0) ? files.byamlBE : files.byaml; //Patched in place
+    Byaml byaml(data.data(), data.size(), false, false);
+    ByamlPatch patch(byaml);
+    auto lastOffset = [&byaml]() {
+        ByamlView type = byaml.GetRoot().At(byaml.GetRoot().GetSize() - 1);
+        ByamlView members = type.Get("a2fb4a94"); //Members
+        return members.At(members.GetSize() - 1).Get("a7bb2e42"); //Offset
+    };
+
+    s64 value = 0;
+    for (auto _ : state) {
+        bool res = patch.SetInt64(lastOffset(), value++);
+        benchmark::DoNotOptimize(res);
+    }
+
+    s64 written = 0;
+    if (byaml.IsBigEndian() != (state.range(0) != 0) || !lastOffset().GetInt64(written) || written != value - 1)
+        state.SkipWithError("Patched value didn't read back");
+}
+BENCHMARK(BM_ByamlPatch_Set)->ArgName("bigEndian")->Arg(0)->Arg(1);
+
+static const char* const BenchQueryPath = "Root/[*]/a2fb4a94/[25efa387=0x10010]/a7bb2e42"; //Offset of one member in every type
+
+static void BM_ByamlQuery_Tree(benchmark::State& state) {
+    Byaml byaml(files.byaml.data(), files.byaml.size(), false);
+    ByamlQuery query(BenchQueryPath);
+    for (auto _ : state) {
+        s64 total = 0;
+        query.Run(byaml, [&total](const ByamlNode& node) {
+            total += node.Int64;
+            return true;
+        });
+        benchmark::DoNotOptimize(total);
+    }
+}
+BENCHMARK(BM_ByamlQuery_Tree);
+
+static void BM_ByamlQuery_View(benchmark::State& state) {
+    Byaml byaml(files.byaml.data(), files.byaml.size(), false, false);
+    ByamlQuery query(BenchQueryPath);
+    for (auto _ : state) {
+        s64 total = 0;
+        query.Run(byaml.GetRoot(), [&total](const ByamlView& view) {
+            s64 offset = 0;
+            view.GetInt64(offset);
+            total += offset;
+            return true;
+        });
+        benchmark::DoNotOptimize(total);
+    }
+}
+BENCHMARK(BM_ByamlQuery_View);
+
+static void BM_ByamlWriter_Write(benchmark::State& state) { //Parsed tree -> new file, tables sorted and data shared
+    Byaml byaml(files.byamlTree.data(), files.byamlTree.size(), false);
+    std::vector<u8> out;
+    for (auto _ : state) {
+        ByamlWriter writer(3);
+        writer.SetRoot(writer.AddNode(byaml.GetRootNode()));
+        out.resize(writer.GetSize());
+        benchmark::DoNotOptimize(writer.WriteTo(out.data(), out.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * out.size());
+}
+BENCHMARK(BM_ByamlWriter_Write);
+
+static void BM_Byaml_ToYaml(benchmark::State& state) { //Emitted through the sink, never held as one string
+    Byaml byaml(files.byamlTree.data(), files.byamlTree.size(), false, false);
+    u64 yamlSize = 0;
+    for (auto _ : state) {
+        yamlSize = 0;
+        byaml.ToYaml([&yamlSize](const char* data, u64 size) {
+            benchmark::DoNotOptimize(data);
+            yamlSize += size;
+            return true;
+        });
+    }
+    state.SetBytesProcessed(state.iterations() * yamlSize);
+}
+BENCHMARK(BM_Byaml_ToYaml);
+
+static void BM_Byaml_FromYaml(benchmark::State& state) {
+    if (!YamlRoundTrips(files.byamlTree, 3) || !YamlRoundTrips(files.byaml, 3) || !YamlRoundTrips(files.byamlScalars, 4)) {
+        state.SkipWithError("YAML didn't round trip");
+        return;
+    }
+
+    Byaml byaml(files.byamlTree.data(), files.byamlTree.size(), false, false);
+    std::string yaml;
+    byaml.ToString(yaml);
+    for (auto _ : state) {
+        ByamlYamlParser parser(3);
+        parser.ParseString(yaml.data(), yaml.size());
+        benchmark::DoNotOptimize(parser.GetWriter().GetSize());
+    }
+    state.SetBytesProcessed(state.iterations() * yaml.size());
+}
+BENCHMARK(BM_Byaml_FromYaml);
+
+static void BM_ACNHByaml_Open(benchmark::State& state) { //Parse + index build
+    for (auto _ : state) {
+        ACNHByaml byaml(files.byaml.data(), files.byaml.size(), false);
+        benchmark::DoNotOptimize(byaml.GetMemberCount());
+    }
+    state.SetBytesProcessed(state.iterations() * files.byaml.size());
+}
+BENCHMARK(BM_ACNHByaml_Open);
+
+static void BM_ACNHByaml_CalcOffsets(benchmark::State& state) {
+    ACNHByaml byaml(files.byaml.data(), files.byaml.size(), false);
+    const std::vector<u32> path = { 0x10000, 0x10004, 0x10008 }; //Members that chain into other types
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(byaml.CalcOffsets(0, path));
+    }
+}
+BENCHMARK(BM_ACNHByaml_CalcOffsets);
+
+/* MSBT */
+
+static void BM_MSBT_Parse(benchmark::State& state) {
+    for (auto _ : state) {
+        MSBT msbt(files.msbt.data(), files.msbt.size(), false);
+        benchmark::DoNotOptimize(msbt.IsValid());
+    }
+    state.SetBytesProcessed(state.iterations() * files.msbt.size());
+}
+BENCHMARK(BM_MSBT_Parse);
+
+static void BM_MSBT_Get(benchmark::State& state) {
+    MSBT msbt(files.msbt.data(), files.msbt.size(), false);
+    std::vector<std::string> labels;
+    for (u32 i = 0; i < MSBTEntryCount; i++)
+        labels.push_back(CorpusGen::MSBTLabel(i));
+
+    std::string text;
+    u32 i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(msbt.Get(labels[i].c_str(), text));
+        i = (i + 1) % MSBTEntryCount;
+    }
+}
+BENCHMARK(BM_MSBT_Get);
+
+/* Algorithms */
+
+static void BM_CRC32_Calc(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(CRC32::Calc(files.hashBuffer.data(), HashBufferSize));
+    }
+    state.SetBytesProcessed(state.iterations() * HashBufferSize);
+}
+BENCHMARK(BM_CRC32_Calc);
+
+static void BM_MurmurHash3_Calc(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MurmurHash3::Calc(files.hashBuffer.data(), 0, HashBufferSize));
+    }
+    state.SetBytesProcessed(state.iterations() * HashBufferSize);
+}
+BENCHMARK(BM_MurmurHash3_Calc);
+
+static void BM_SeadRandom_GetU32(benchmark::State& state) {
+    sead::Random random(0x12345678);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(random.GetU32());
+    }
+}
+BENCHMARK(BM_SeadRandom_GetU32);
+
+static void BM_SeadRandom_GetU64(benchmark::State& state) {
+    sead::Random random(0x12345678);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(random.GetU64());
+    }
+}
+BENCHMARK(BM_SeadRandom_GetU64);
+
+/* Cryptography */
+
+static void BM_SaveCrypto_Crypt(benchmark::State& state) {
+    GSaveVersion header = {};
+    SaveCrypto::RegenHeaderCrypto(header, 0x12345678);
+    std::vector<u8> save = files.hashBuffer;
+    for (auto _ : state) {
+        if (!SaveCrypto::Crypt(header, save.data(), static_cast<u32>(save.size()))) {
+            state.SkipWithError("Crypt failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * save.size());
+}
+BENCHMARK(BM_SaveCrypto_Crypt);
+
+static void BM_BFTTF_Decrypt(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(BFTTF::Decrypt(files.ttfPath.c_str(), files.bfttfPath.c_str()));
+    }
+    state.SetBytesProcessed(state.iterations() * BFTTFSize);
+}
+BENCHMARK(BM_BFTTF_Decrypt);
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    if (!SetupFiles()) {
+        fprintf(stderr, "Failed to generate benchmark fixtures\n");
+        CleanupFiles();
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    CleanupFiles();
+    return 0;
+}
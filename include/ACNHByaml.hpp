@@ -22,21 +22,39 @@
 
 #pragma once
 #include "Byaml.hpp"
+#include <unordered_map>
+
+struct ACNHByamlMember {
+    u32 typeName; //Owning type
+    u32 name;
+    u32 memberTypeName; //Type of the member itself, same as typeName if the member has none
+    u64 offset;
+    u64 size;
+    const ByamlNode* node; //Member hash node
+};
 
 class ACNHByaml : public Byaml {
 private:
-    u64 CalcOffset(u32& typeName, u32 fieldName);
-    u64 GetSize(u32& typeName, u32 fieldName);
-    u64 GetSize(u32& typeName, u32 fieldName, ByamlNode &node);
-    ByamlNode GetNode(u32& typeName, u32 fieldName);
+    void BuildIndex();
+    const ACNHByamlMember* FindMember(u32 typeName, u32 fieldName) const;
+
+    static ALWAYS_INLINE u64 MemberKey(u32 typeName, u32 fieldName) {
+        return (static_cast<u64>(typeName) << 32) | fieldName;
+    }
+
+    //Built once at construction: members are stored flat, in file order, and found with one probe per path component
+    std::vector<ACNHByamlMember> members;
+    std::unordered_map<u64, u32> memberIndices; //MemberKey -> members index
 
 public:
-    ACNHByaml(const char* filePath);
+    ACNHByaml(const char* filePath, bool mapFile = false);
     ACNHByaml(u8* inBuffer, u64 bufSize, bool manageMem = false);
     ~ACNHByaml() override;
 
     u64 CalcOffsets(u32 fieldType, const std::vector<u32>& fieldNames);
     u64 GetSize(u32 fieldType, const std::vector<u32>& fieldNames);
     ByamlNode GetNode(u32 fieldType, const std::vector<u32>& fieldNames);
-    
-};
\ No newline at end of file
+
+    bool GetMember(u32 typeName, u32 fieldName, ACNHByamlMember& outMember) const;
+    u32 GetMemberCount() const;
+};
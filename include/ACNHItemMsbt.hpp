@@ -28,7 +28,7 @@ private:
     void FixItemNames();
 
 public:
-    ACNHItemMsbt(const char* filePath);
+    ACNHItemMsbt(const char* filePath, bool mapFile = false);
     ACNHItemMsbt(u8* inBuffer, u64 bufSize, bool manageMem = false);
     ~ACNHItemMsbt() override;
 
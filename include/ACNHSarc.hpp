@@ -23,8 +23,18 @@
 #pragma once
 #include "SARC.hpp"
 
+class ZstdStream;
+
 class ACNHSarc : public SARC {
+protected:
+    bool LoadFile(const SARCFileInfo& info) override;
+    void InitLazy(const char* filePath);
+
+    ZstdStream* stream = nullptr; //Only set in lazy mode, owns 'data'
+
 public:
-    ACNHSarc(const char* filePath);
+    //Lazy mode only decompresses the SFAT/SFNT tables up front, file data is decompressed when first requested
+    ACNHSarc(const char* filePath, bool lazy = false);
     ~ACNHSarc() override;
-};
\ No newline at end of file
+    u64 GetDecompressedSize() const;
+};
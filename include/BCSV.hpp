@@ -22,9 +22,11 @@
 
 #pragma once
 #include "types.hpp"
+#include "Endian.hpp"
 #include <vector>
 #include <map>
-#include <limits>
+#include <unordered_map>
+#include <atomic>
 
 enum class ColumnType : u8 {
     UInt8,
@@ -51,42 +53,156 @@ struct BCSVField {
 typedef std::map<u32, BCSVField> BCSVRow;
 typedef std::vector<BCSVRow> BCSVData;
 
+struct BCSVColumn {
+    u32 hash;
+    u32 offset; //Within a row
+    u32 size; //Bytes per cell, up to the next column (or the end of the row)
+    ColumnType type; //Same for every cell, declared by the schema or inferred from the cell size and values
+    bool declared; //Type came from the schema
+    u32 valueIndex; //Start of this column's values in the pool for its type
+};
+
+/**
+ * BCSVSchema: declared column types by column hash (CRC32 of the column name)
+ * Columns without an entry are typed by cell size, and 4 byte columns are Float if every non-zero cell
+ * is a positive, normal float. That column scan runs when rows are parsed, or on the column's first
+ * access otherwise, so opening unparsed stays O(columns). A declaration wider than the cell is ignored.
+ * Lookups aren't locked, so register everything before parsing tables on other threads.
+ */
+
+class BCSVSchema {
+protected:
+    std::unordered_map<u32, ColumnType> types;
+
+public:
+    void Register(u32 columnHash, ColumnType type);
+    void Register(const char* columnName, ColumnType type);
+    bool Unregister(u32 columnHash);
+    void Clear();
+    bool Find(u32 columnHash, ColumnType& outType) const;
+    u32 GetSize() const;
+
+    static BCSVSchema& Default(); //Used by tables opened without a schema
+};
+
+class BCSV;
+
+/**
+ * BCSVRowView / BCSVColumnView: non-owning cursors over a BCSV's storage, nothing is copied
+ * Small values (copy freely), valid while their BCSV is alive and not moved from.
+ */
+
+class BCSVRowView {
+    friend class BCSV;
+
+protected:
+    BCSVRowView(const BCSV* bcsv, u32 row);
+
+    const BCSV* bcsv = nullptr;
+    u32 row = 0;
+
+public:
+    BCSVRowView() = default;
+    bool IsValid() const;
+    u32 GetIndex() const;
+
+    template<typename T> bool Get(u32 columnHash, T& outValue) const; //See BCSV::Get
+    template<typename T> bool Get(const BCSVColumn& column, T& outValue) const;
+    bool GetField(u32 columnHash, BCSVField& outField) const;
+    bool GetFieldByIndex(u16 columnIndex, BCSVField& outField) const; //File order, see BCSV::GetColumnInfoByIndex
+};
+
+class BCSVColumnView {
+    friend class BCSV;
+
+protected:
+    BCSVColumnView(const BCSV* bcsv, const BCSVColumn* column);
+
+    const BCSV* bcsv = nullptr;
+    const BCSVColumn* column = nullptr;
+
+public:
+    class Iterator { //Yields each row's field by value
+    protected:
+        const BCSVColumnView* view;
+        u32 row;
+
+    public:
+        Iterator(const BCSVColumnView* view, u32 row) : view(view), row(row) {}
+        BCSVField operator*() const { return (*view)[row]; }
+        Iterator& operator++() { row++; return *this; }
+        bool operator==(const Iterator& other) const { return row == other.row; }
+        bool operator!=(const Iterator& other) const { return row != other.row; }
+    };
+
+    BCSVColumnView() = default;
+    bool IsValid() const;
+    u32 GetSize() const; //Row count
+    const BCSVColumn* GetInfo() const;
+
+    BCSVField operator[](u32 row) const; //Row must be < GetSize()
+    template<typename T> bool Get(u32 row, T& outValue) const; //See BCSV::Get
+    Iterator begin() const;
+    Iterator end() const;
+};
+
+/**
+ * BCSV: rows are decoded once into columns, not per-row maps
+ * The column directory is kept sorted by hash, and each column's values are stored contiguously (one pool
+ * per column type), so a column scan is a linear walk over a typed array and a cell costs its own size.
+ * Types are resolved once per column (see BCSVSchema), so every cell of a column has the same type.
+ * With parseRows = false only the column directory is read, and cells are read in place with Get.
+ */
+
 class BCSV {
+    friend class BCSVRowView;
+    friend class BCSVColumnView;
+    friend class BCSVIndex;
+
 protected:
     inline void InValidate(const char* message) {
         this->isValid = false;
         this->errorMessage = message;
     }
 
-    ALWAYS_INLINE u16 ReadU16(void* address) const {
-        u16 val = *(u16 *)(address);
-        return val;
+    ALWAYS_INLINE u16 ReadU16(const void* address) const {
+        return Endian::ReadU16<false>(address);
     }
 
-    ALWAYS_INLINE u32 ReadU32(void* address) const {
-        u32 val = *(u32 *)(address);
-        return val;
+    ALWAYS_INLINE u32 ReadU32(const void* address) const {
+        return Endian::ReadU32<false>(address);
     }
 
-    ALWAYS_INLINE float ReadFloat(void* address) const {
-        float val = *(float*)(address);
-        return val;
+    ALWAYS_INLINE float ReadFloat(const void* address) const {
+        return Endian::ReadFloat<false>(address);
     }
 
-    ALWAYS_INLINE bool IsFloat(u32 val) const {
-        if (val == 0) return false; //Assume 0 is u32
+    enum ColumnCheck : u8 {
+        Check_Done = 0,
+        Check_Pending, //4 byte column without a schema entry, UInt32 until IsFloatColumn has run
+        Check_Running
+    };
 
-        float fVal = ReadFloat(&val); //Converts hex representation to actual float val, e.g. 0x3F800000 == 1.0f
-        return fVal >= std::numeric_limits<float>::min() && fVal <= std::numeric_limits<float>::max();
+    ALWAYS_INLINE const u8* GetCell(u32 row, const BCSVColumn& column) const { //Rows are fixed size
+        return data + rowsStart + (static_cast<u64>(row) * rowSize) + column.offset;
     }
 
-    void Init();
-    void Parse();
+    void Init(bool parseRows, const BCSVSchema* schema);
+    void FreeData();
+    void MoveFrom(BCSV& other);
+    bool ParseColumns(const BCSVSchema& schema);
+    bool IsFloatColumn(const BCSVColumn& column) const;
+    const BCSVColumn* CheckColumn(const BCSVColumn* column) const;
+    void CheckColumns() const;
+    void ParseRows();
+    const BCSVColumn* FindColumn(u32 columnHash) const;
+    BCSVField GetField(const BCSVColumn& column, u32 row) const;
 
     u8 *data = nullptr;
     u64 dataSize = 0;
     const char *errorMessage = "No Error";
     bool autoManageMem = false;
+    bool autoUnmapMem = false;
     bool isValid = true;
 
     u32 numRows = 0;
@@ -95,20 +211,115 @@ protected:
     u8 version = 0xFF;
     bool jpEnumFlag = false;
     u32 startPos = 0;
+    u32 rowsStart = 0;
+    bool isParsed = false;
 
-    BCSVData csvData;
+    mutable std::vector<BCSVColumn> columns; //File order, pending types are settled by CheckColumn
+    mutable std::vector<std::atomic<u8>> columnChecks; //ColumnCheck per column, empty if none are pending
+    std::vector<u16> columnsByHash; //Indices into 'columns', sorted by hash
+    std::vector<u8> u8Values;
+    std::vector<u16> u16Values;
+    std::vector<u32> u32Values;
+    std::vector<float> floatValues;
+    std::vector<const char*> stringValues; //Point into data, not null terminated if the cell is full
 
 public:
-    BCSV(const char* filePath);
-    BCSV(u8* inBuffer, u64 bufSize, bool manageMem = false);
+    //parseRows = false only reads the column directory, use Get to read cells in place
+    //Column types come from 'schema', or BCSVSchema::Default() when null
+    BCSV(const char* filePath, bool mapFile = false, bool parseRows = true, const BCSVSchema* schema = nullptr);
+    BCSV(u8* inBuffer, u64 bufSize, bool manageMem = false, bool parseRows = true, const BCSVSchema* schema = nullptr);
+    BCSV(const BCSV&) = delete;
+    BCSV& operator=(const BCSV&) = delete;
+    BCSV(BCSV&& other) noexcept; //Takes ownership of the other table's data and storage
+    BCSV& operator=(BCSV&& other) noexcept;
     virtual ~BCSV();
     bool IsValid() const;
+    bool IsParsed() const;
     const char* GetErrorMessage() const;
     void Print() const;
 
+    //Views into the table, nothing is copied; invalid views if the row/column doesn't exist
+    BCSVRowView GetRowView(u32 index) const;
+    BCSVColumnView GetColumnView(u32 columnHash) const;
+
+    //Copies built from the columns on each call, prefer the views in loops
     bool GetAll(BCSVData& outData) const;
     bool GetColumnByHash(std::vector<BCSVField>& outCols, u32 columnHash) const;
     u32 GetRowCount() const;
     u32 GetColCount() const;
     bool GetRow(BCSVRow& outRow, u32 index) const;
+
+    const BCSVColumn* GetColumnInfo(u32 columnHash) const; //nullptr if there's no such column
+    const BCSVColumn* GetColumnInfoByIndex(u16 index) const; //File order
+
+    //A cell read straight from the file data, parsed or not. T is u8, u16, u32, float or const char*
+    //and must match the column's type; false if it doesn't or the column/row is missing
+    template<typename T>
+    ALWAYS_INLINE bool Get(u32 row, u32 columnHash, T& outValue) const {
+        const BCSVColumn* column = GetColumnInfo(columnHash);
+        return column != nullptr && Get(row, *column, outValue);
+    }
+
+    //Same, with a column from GetColumnInfo to skip the lookup in loops
+    ALWAYS_INLINE bool Get(u32 row, const BCSVColumn& column, u8& outValue) const {
+        if (!isValid || row >= numRows || column.type != ColumnType::UInt8)
+            return false;
+
+        outValue = *GetCell(row, column);
+        return true;
+    }
+
+    ALWAYS_INLINE bool Get(u32 row, const BCSVColumn& column, u16& outValue) const {
+        if (!isValid || row >= numRows || column.type != ColumnType::UInt16)
+            return false;
+
+        outValue = ReadU16(GetCell(row, column));
+        return true;
+    }
+
+    ALWAYS_INLINE bool Get(u32 row, const BCSVColumn& column, u32& outValue) const {
+        if (!isValid || row >= numRows || column.type != ColumnType::UInt32)
+            return false;
+
+        outValue = ReadU32(GetCell(row, column));
+        return true;
+    }
+
+    ALWAYS_INLINE bool Get(u32 row, const BCSVColumn& column, float& outValue) const {
+        if (!isValid || row >= numRows || column.type != ColumnType::Float)
+            return false;
+
+        outValue = ReadFloat(GetCell(row, column));
+        return true;
+    }
+
+    ALWAYS_INLINE bool Get(u32 row, const BCSVColumn& column, const char*& outValue) const {
+        if (!isValid || row >= numRows || column.type != ColumnType::String)
+            return false;
+
+        outValue = reinterpret_cast<const char*>(GetCell(row, column));
+        return true;
+    }
+
+    //A column's values as one array of GetRowCount() values, false if it's missing, stores another type or rows weren't parsed
+    bool GetColumn(u32 columnHash, const u8*& outValues) const;
+    bool GetColumn(u32 columnHash, const u16*& outValues) const;
+    bool GetColumn(u32 columnHash, const u32*& outValues) const;
+    bool GetColumn(u32 columnHash, const float*& outValues) const;
+    bool GetColumn(u32 columnHash, const char* const*& outValues) const;
 };
+
+template<typename T>
+bool BCSVRowView::Get(u32 columnHash, T& outValue) const {
+    return IsValid() && bcsv->Get(row, columnHash, outValue);
+}
+
+template<typename T>
+bool BCSVRowView::Get(const BCSVColumn& column, T& outValue) const {
+    return IsValid() && bcsv->Get(row, column, outValue);
+}
+
+template<typename T>
+bool BCSVColumnView::Get(u32 row, T& outValue) const {
+    return IsValid() && bcsv->Get(row, *column, outValue);
+}
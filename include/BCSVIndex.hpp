@@ -0,0 +1,98 @@
+/**
+ *
+ * BCSVIndex.hpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+
+#pragma once
+#include "types.hpp"
+#include "BCSV.hpp"
+#include <vector>
+#include <unordered_map>
+
+/**
+ * BCSVIndex: lookups by value on a BCSV's key columns (UInt8, UInt16, UInt32 and String), instead of scanning rows
+ * A column is indexed on its first query (or with Build): its rows sorted by value, which answers range queries,
+ * plus an open addressing hash table over the distinct values, so an equality lookup costs one probe sequence.
+ * Indexes can be saved to a cache file, which is only loaded back for the exact same table data.
+ * Valid while the BCSV is alive and not moved from. Queries can build indexes, so don't share one across threads.
+ */
+
+class BCSVIndex {
+protected:
+    inline void InValidate(const char* message) {
+        this->isValid = false;
+        this->errorMessage = message;
+    }
+
+    inline bool Fail(const char* message) { //Query errors leave the index usable
+        this->errorMessage = message;
+        return false;
+    }
+
+    struct ColumnIndex {
+        const BCSVColumn* column = nullptr;
+        std::vector<u32> rows; //Sorted by value, equal values in row order
+        std::vector<u32> keys; //Numeric columns: the value of each entry in 'rows'
+        std::vector<u32> groups; //Start of each run of equal values in 'rows', then rows.size()
+        std::vector<u32> slots; //Hash of a group's value -> group index + 1 (0 is empty), power of 2 size
+    };
+
+    ColumnIndex* GetIndex(u32 columnHash);
+    void SortRows(ColumnIndex& index) const;
+    bool BuildGroups(ColumnIndex& index) const;
+    void BuildSlots(ColumnIndex& index) const;
+    u32 ReadKey(const BCSVColumn& column, u32 row) const;
+    const char* ReadString(const BCSVColumn& column, u32 row, u32& outLength) const;
+    u32 FindGroup(const ColumnIndex& index, u32 value) const; //Group index, or groups.size()-1 if missing
+    u32 FindGroup(const ColumnIndex& index, const char* value) const;
+    u64 GetFingerprint();
+
+    const BCSV& bcsv;
+    std::unordered_map<u32, ColumnIndex> indexes; //Column hash -> index
+    u64 fingerprint = 0;
+    bool fingerprintBuilt = false;
+
+    const char* errorMessage = "No Error";
+    bool isValid = true;
+
+public:
+    BCSVIndex(const BCSV& bcsv);
+    bool IsValid() const;
+    const char* GetErrorMessage() const; //Also why the last query failed
+
+    bool Build(u32 columnHash); //Queries build indexes on first use, this only moves the cost up front
+    bool IsBuilt(u32 columnHash) const;
+
+    //First row (in row order) holding 'value', false if there's none or the column can't be indexed
+    bool FindRow(u32 columnHash, u32 value, u32& outRow);
+    bool FindRow(u32 columnHash, const char* value, u32& outRow);
+
+    //Every row holding 'value', in row order. outCount is 0 if there's none
+    bool EqualRange(u32 columnHash, u32 value, const u32*& outRows, u32& outCount);
+    bool EqualRange(u32 columnHash, const char* value, const u32*& outRows, u32& outCount);
+
+    //Rows with minValue <= value <= maxValue on a numeric column, ordered by value (then row)
+    bool Range(u32 columnHash, u32 minValue, u32 maxValue, const u32*& outRows, u32& outCount);
+
+    //Cache of every built index. Load fails if the file was saved for different table data, and keeps what's built
+    bool Save(const char* filePath);
+    bool Load(const char* filePath);
+};
@@ -0,0 +1,85 @@
+/**
+ *
+ * BatchLoader.hpp
+ *
+ * Copyright (c) 2021-2025, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#pragma once
+#include "types.hpp"
+#include "SARC.hpp"
+#include "Byaml.hpp"
+#include "BCSV.hpp"
+#include "MSBT.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+enum class BatchFileType : u8 {
+    Unknown,
+    SARC,
+    ACNHSarc, //zstd frame, decompressed and parsed as a SARC
+    Byaml,
+    BCSV,
+    MSBT
+};
+
+struct BatchResult {
+    std::string path;
+    BatchFileType type = BatchFileType::Unknown;
+    bool isValid = false;
+    const char* errorMessage = "No Error";
+    u64 fileSize = 0;
+    u64 elapsedNs = 0; //Time spent opening and parsing this file
+    u64 waitNs = 0; //Time spent waiting for maxBytesInFlight before decoding, not included in elapsedNs
+
+    //Only the member matching 'type' is set; ACNHSarc results are stored in 'sarc'
+    std::unique_ptr<SARC> sarc;
+    std::unique_ptr<Byaml> byaml;
+    std::unique_ptr<BCSV> bcsv;
+    std::unique_ptr<MSBT> msbt;
+};
+
+/**
+ * BatchLoader: decodes many files in parallel on a work-stealing thread pool
+ * Files are dispatched by magic (BCSV v0 has none, so it's detected by its .bcsv extension).
+ * At most 'maxBytesInFlight' bytes of (decompressed) input are decoded at once.
+ */
+
+class BatchLoader {
+protected:
+    bool Run(const std::vector<std::string>& paths, const std::function<void(size_t, BatchResult&)>& onResult) const;
+    static void Decode(BatchResult& result, bool mapFiles);
+
+    u32 threadCount;
+    u64 maxBytesInFlight;
+    bool mapFiles;
+
+public:
+    BatchLoader(u32 threadCount = 0, u64 maxBytesInFlight = 0x10000000, bool mapFiles = true); //threadCount 0 == hardware threads
+    u32 GetThreadCount() const;
+
+    //Results are in the same order as 'paths'
+    bool Load(const std::vector<std::string>& paths, std::vector<BatchResult>& outResults) const;
+    //Each result is handed to 'callback' (serialized, from a worker thread) and freed afterwards unless moved from
+    bool Load(const std::vector<std::string>& paths, const std::function<void(BatchResult&)>& callback) const;
+
+    static BatchFileType DetectType(const char* filePath, u64& outFileSize, u64& outDecodedSize);
+    static bool LoadFile(BatchResult& result, bool mapFiles = true);
+};
@@ -22,9 +22,12 @@
 
 #pragma once
 #include "types.hpp"
+#include "Endian.hpp"
+#include <cstdio>
 #include <vector>
-#include <map>
 #include <string>
+#include <unordered_map>
+#include <functional>
 
 enum class NodeType : u8 {
     String = 0xA0,
@@ -43,6 +46,9 @@ enum class NodeType : u8 {
     Null = 0xFF
 };
 
+struct ByamlHashEntry;
+
+//Container nodes point into their Byaml's arena, so nodes (and copies of them) are only valid while it's alive
 struct ByamlNode {
     NodeType type;
     u64 size;
@@ -51,8 +57,8 @@ struct ByamlNode {
         void* raw;
         const char* string;
         u8* bytes;
-        std::vector<ByamlNode>* array;
-        std::map<const char*, ByamlNode>* hash;
+        ByamlNode* array; //'size' nodes
+        ByamlHashEntry* hash; //'size' entries, in file order (sorted by key index)
         bool Bool;
         s32 Int;
         float Float;
@@ -63,10 +69,97 @@ struct ByamlNode {
     };
 
     void Find(std::vector<ByamlNode>& outNodes, const char* keyName, bool found = false);
+    void FindByKeyIndex(std::vector<ByamlNode>& outNodes, u32 keyIndex, bool found = false);
     std::vector<ByamlNode> operator[](const char* keyName);
+
+    //Hash child lookup, binary search over the entries (sorted by key index); nullptr if not found
+    const ByamlNode* GetByKeyIndex(u32 keyIndex) const;
+};
+
+struct ByamlHashEntry {
+    const char* key;
+    u32 keyIndex; //Index into the hash key table
+    ByamlNode node;
+};
+
+/**
+ * ByamlArena: owns the node storage of a parsed Byaml
+ * Both arrays are sized up front from the container counts in the file, then handed out in order,
+ * so a whole tree costs two allocations and is freed in one go.
+ */
+
+class ByamlArena {
+protected:
+    ByamlNode* nodes = nullptr;
+    ByamlHashEntry* entries = nullptr;
+    u64 nodeCount = 0, nodePos = 0;
+    u64 entryCount = 0, entryPos = 0;
+
+public:
+    ByamlArena() = default;
+    ByamlArena(const ByamlArena&) = delete;
+    ByamlArena& operator=(const ByamlArena&) = delete;
+    ~ByamlArena();
+
+    void Reserve(u64 nodeCount, u64 entryCount);
+    void Clear();
+    ByamlNode* AllocNodes(u64 count);
+    ByamlHashEntry* AllocEntries(u64 count);
+    u64 GetNodeCount() const;
+    u64 GetEntryCount() const;
+};
+
+class Byaml;
+
+/**
+ * ByamlView: cursor over a Byaml that reads straight from its data, nothing is parsed up front
+ * Children are only decoded when visited, so a lookup only touches the bytes on its path.
+ * Views are small values (copy freely), valid while their Byaml is alive.
+ */
+
+class ByamlView {
+    friend class Byaml;
+    friend class ByamlQuery;
+    friend class ByamlPatch;
+
+protected:
+    ByamlView(const Byaml* byaml, NodeType type, u32 valueOffset);
+    bool CheckContainer() const;
+
+    const Byaml* byaml = nullptr;
+    NodeType type = NodeType::Null;
+    u32 valueOffset = 0; //Where the node's 4 byte value is stored (hash/array entry or header root offset)
+    u32 nodeOffset = 0; //Container data (Array/Hash) or out-of-line data (Binary, 64-bit types)
+
+public:
+    ByamlView() = default;
+    bool IsValid() const;
+    NodeType GetType() const;
+    bool IsArray() const;
+    bool IsHash() const;
+    u32 GetSize() const; //Child count for containers, 0 otherwise
+
+    //Array elements and hash entries by index (hash entries are sorted by key index)
+    ByamlView At(u32 index) const;
+    const char* GetKey(u32 index) const;
+    ByamlView Get(const char* key) const; //Hash lookup, invalid view if not found
+    ByamlView GetByKeyIndex(u32 keyIndex) const; //Same, with a key index from Byaml::GetKeyIndex
+
+    bool GetBool(bool& outValue) const;
+    bool GetInt(s32& outValue) const;
+    bool GetUInt(u32& outValue) const;
+    bool GetFloat(float& outValue) const;
+    bool GetInt64(s64& outValue) const;
+    bool GetUInt64(u64& outValue) const;
+    bool GetDouble(double& outValue) const;
+    bool GetString(const char*& outValue) const;
+    bool GetBinary(const u8*& outData, u32& outSize) const;
 };
 
 class Byaml {
+    friend class ByamlView;
+    friend class ByamlPatch;
+
 protected:
     inline void InValidate(const char* message) {
         this->isValid = false;
@@ -93,111 +186,117 @@ protected:
         return type == NodeType::StringTable;
     }
 
-    ALWAYS_INLINE u8 ReadU8(void* address) const {
-        return *(u8*)(address);
+    ALWAYS_INLINE u8 ReadU8(const void* address) const {
+        return *static_cast<const u8*>(address);
     }
 
-    ALWAYS_INLINE u16 ReadU16(void* address) const {
-        u16 val = *(u16*)(address);
-        if (bigEndian)
-            return __builtin_bswap16(val);
-        return val;
+    //Byte order picked at runtime, for one-off reads (views, header); the tree parser is instantiated per byte order
+    ALWAYS_INLINE u16 ReadU16(const void* address) const {
+        return bigEndian ? Endian::ReadU16<true>(address) : Endian::ReadU16<false>(address);
     }
 
-    ALWAYS_INLINE u32 ReadU24(void* address) const {
-        u32 val = (*(u32*)(address)) & 0x00FFFFFF;
-        if (bigEndian)
-            return (__builtin_bswap32(val) >> 8) & 0x00FFFFFF;
-        return val;
+    ALWAYS_INLINE u32 ReadU24(const void* address) const {
+        return bigEndian ? Endian::ReadU24<true>(address) : Endian::ReadU24<false>(address);
     }
 
-    ALWAYS_INLINE u32 ReadU32(void* address) const {
-        u32 val = *(u32*)(address);
-        if (bigEndian)
-            return __builtin_bswap32(val);
-        return val;
+    ALWAYS_INLINE u32 ReadU32(const void* address) const {
+        return bigEndian ? Endian::ReadU32<true>(address) : Endian::ReadU32<false>(address);
     }
 
-    ALWAYS_INLINE s32 ReadS32(void* address) const {
-        u32 val = *(u32*)(address);
-        if (bigEndian)
-            return static_cast<s32>(__builtin_bswap32(val));
-        return static_cast<s32>(val);
+    ALWAYS_INLINE s32 ReadS32(const void* address) const {
+        return bigEndian ? Endian::ReadS32<true>(address) : Endian::ReadS32<false>(address);
     }
 
-    ALWAYS_INLINE u64 ReadU64(void* address) const {
-        u64 val = *(u64*)(address);
-        if (bigEndian)
-            return __builtin_bswap64(val);
-        return val;
+    ALWAYS_INLINE u64 ReadU64(const void* address) const {
+        return bigEndian ? Endian::ReadU64<true>(address) : Endian::ReadU64<false>(address);
     }
 
-    ALWAYS_INLINE s64 ReadS64(void* address) const {
-        u64 val = *(u64*)(address);
-        if (bigEndian)
-            return static_cast<s64>(__builtin_bswap64(val));
-        return static_cast<s64>(val);
+    ALWAYS_INLINE s64 ReadS64(const void* address) const {
+        return bigEndian ? Endian::ReadS64<true>(address) : Endian::ReadS64<false>(address);
     }
 
-    ALWAYS_INLINE float ReadFloat(void* address) const {
-        u32 val = *(u32*)(address);
-        if (bigEndian)
-            return static_cast<float>(__builtin_bswap32(val));
-        return static_cast<float>(val);
+    ALWAYS_INLINE float ReadFloat(const void* address) const {
+        return bigEndian ? Endian::ReadFloat<true>(address) : Endian::ReadFloat<false>(address);
     }
 
-    ALWAYS_INLINE double ReadDouble(void* address) const {
-        u64 val = *(u64*)(address);
-        if (bigEndian)
-            return static_cast<double>(__builtin_bswap64(val));
-        return static_cast<double>(val);
+    ALWAYS_INLINE double ReadDouble(const void* address) const {
+        return bigEndian ? Endian::ReadDouble<true>(address) : Endian::ReadDouble<false>(address);
     }
 
-    ByamlNode ParseStringNode(u32 index);
-    ByamlNode ParseBinaryNode(u32 offset);
-    ByamlNode ParseArrayNode(u32 offset);
-    ByamlNode ParseHashNode(u32 offset);
-    ByamlNode ParseBoolNode(u32 offset);
-    ByamlNode ParseIntNode(u32 offset);
-    ByamlNode ParseFloatNode(u32 offset);
-    ByamlNode ParseUIntNode(u32 offset);
-    ByamlNode ParseInt64Node(u32 offset);
-    ByamlNode ParseUInt64Node(u32 offset);
-    ByamlNode ParseDoubleNode(u32 offset);
+    template<bool BigEndian> ByamlNode ParseStringNode(u32 index);
+    template<bool BigEndian> ByamlNode ParseBinaryNode(u32 offset);
+    template<bool BigEndian> ByamlNode ParseArrayNode(u32 offset);
+    template<bool BigEndian> ByamlNode ParseHashNode(u32 offset);
+    template<bool BigEndian> ByamlNode ParseBoolNode(u32 offset);
+    template<bool BigEndian> ByamlNode ParseIntNode(u32 offset);
+    template<bool BigEndian> ByamlNode ParseFloatNode(u32 offset);
+    template<bool BigEndian> ByamlNode ParseUIntNode(u32 offset);
+    template<bool BigEndian> ByamlNode ParseInt64Node(u32 offset);
+    template<bool BigEndian> ByamlNode ParseUInt64Node(u32 offset);
+    template<bool BigEndian> ByamlNode ParseDoubleNode(u32 offset);
     ByamlNode ParseNullNode();
 
-    void Init();
+    //Containers can be referenced from several places (ByamlWriter shares identical ones), so each is counted and parsed once
+    enum ContainerFlags : u16 {
+        Container_Counting = 0x7FFF, //Children still being counted, reaching it again is a cycle
+        Container_Shared = 0x8000 //Reached more than once, its parsed node is kept in sharedNodes
+    };
 
-    ByamlNode ParseNode(NodeType node, u32 offset);
-    bool ParseTable(u32 offset, std::vector<const char*>& table);
-    bool Parse();
+    void Init(bool parseTree);
+    const char* ReadTableString(u32 tableOffset, u32 index) const;
+    bool FindTableIndex(u32 tableOffset, const char* str, u32& outIndex) const;
 
-    void printTabs(u32 indent, std::string& outString, NodeType type) const;
-    void Print(const ByamlNode& node, std::string& outString, u32 indent) const;
+    template<bool BigEndian> ByamlNode ParseNode(NodeType node, u32 offset);
+    template<bool BigEndian> bool CountContainer(NodeType node, u32 offset, u32 depth, u64& nodeCount, u64& entryCount, u32& outHeight);
+    template<bool BigEndian> bool ParseTable(u32 offset, std::vector<const char*>& table);
+    template<bool BigEndian> bool Parse();
 
     u8* data = nullptr;
     u64 dataSize = 0;
     const char* errorMessage = "No Error";
     bool autoManageMem = false;
+    bool autoUnmapMem = false;
 
-    bool bigEndian;
+    bool bigEndian = false;
     bool isValid = true;
+    bool isParsed = false;
+
+    u32 hashKeyTableOffset = 0;
+    u32 stringTableOffset = 0;
+    u32 rootOffset = 0;
 
     ByamlNode parentNode;
+    ByamlArena arena;
+    std::vector<u16> containerFlags; //Per 4 byte word, only while parsing: container height (levels from it down, 0 if not reached) | ContainerFlags
+    std::unordered_map<u32, ByamlNode> sharedNodes; //Offset -> parsed node of shared containers, only while parsing
 
     std::vector<const char*> stringTable;
     std::vector<const char*> hashTable;
 
 public:
-    Byaml(const char* filePath);
-    Byaml(u8* inBuffer, u64 bufSize, bool manageMem = false);
+    //parseTree = false only checks the header, use GetRoot() to read values in place
+    Byaml(const char* filePath, bool mapFile = false, bool parseTree = true);
+    Byaml(u8* inBuffer, u64 bufSize, bool manageMem = false, bool parseTree = true);
     virtual ~Byaml();
     bool IsValid() const;
+    bool IsParsed() const;
+    bool IsBigEndian() const; //"BY" files (Wii U and older), values are decoded to host order
     const char* GetErrorMessage() const;
+    ByamlView GetRoot() const;
+    const ByamlNode& GetRootNode() const; //Null node unless parsed
+
+    //Key tables are sorted, so a key resolves to its index with a binary search; resolve once, look up many times
+    bool GetKeyIndex(const char* key, u32& outIndex) const;
+    bool GetStringIndex(const char* str, u32& outIndex) const; //Same, for the string value table
+    const ByamlNode* Get(const ByamlNode& hashNode, const char* key) const;
 
+    //YAML text (see ByamlYaml.hpp), read through GetRoot() so the tree doesn't need to be parsed
     bool ToString(std::string& outStr) const;
     bool ToYaml(const char* filePath) const;
-    static Byaml* FromYaml(const char* filePath);
+    bool ToYaml(FILE* file) const;
+    bool ToYaml(int fd) const;
+    bool ToYaml(const std::function<bool(const char* data, u64 size)>& sink) const;
+    static Byaml* FromYaml(const char* filePath, u16 version = 3); //nullptr on error, ByamlYamlParser reports why
 
     std::vector<ByamlNode> operator[](const char* keyName);
 };
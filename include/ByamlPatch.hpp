@@ -0,0 +1,107 @@
+/**
+ *
+ * ByamlPatch.hpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+
+#pragma once
+#include "types.hpp"
+#include "Byaml.hpp"
+#include <vector>
+#include <unordered_map>
+
+struct ByamlDirtyRange {
+    u64 offset;
+    u64 size;
+};
+
+/**
+ * ByamlPatch: edits values in place, straight in a Byaml's data, with no reparse or rewrite of the file
+ * Only a node's 4 byte value slot (or the 8 bytes a 64-bit node points to) is written, so a patch costs
+ * the lookup of its path. Writes are recorded as sorted, merged dirty ranges, so only those bytes need saving.
+ * A parsed tree (GetRootNode) is a decoded copy and keeps the old values, read patched values through views.
+ *
+ * Containers and 64-bit values can be referenced from several places (ByamlWriter shares identical ones), and
+ * patching those would change every reference. The first patch walks the file once to find them, and patches
+ * that would change more than their own node are refused. Pass checkShared = false to skip the walk for files
+ * known not to share data (e.g. the game's own files).
+ */
+
+class ByamlPatch {
+protected:
+    inline void InValidate(const char* message) {
+        this->isValid = false;
+        this->errorMessage = message;
+    }
+
+    inline bool Fail(const char* message) { //Patch errors leave the patcher usable
+        this->errorMessage = message;
+        return false;
+    }
+
+    enum DataFlags : u8 { //Per 4 byte word of the file
+        Flag_Visited = 1 << 0, //Container or 64-bit value reached from the root
+        Flag_Shared = 1 << 1, //... through more than one path
+        Flag_SharedSlot = 1 << 2 //Value slot of a shared container
+    };
+
+    bool BuildSharedIndex();
+    void MarkShared(const ByamlView& container);
+    void BuildDataOffsets();
+    bool HasFlag(u32 offset, u8 flag) const;
+    bool CheckNode(const ByamlView& node, NodeType type);
+    bool Set32(const ByamlView& node, NodeType type, u32 value);
+    bool Set64(const ByamlView& node, NodeType type, u64 value);
+    void WriteU32(u32 offset, u32 value);
+    void WriteU64(u32 offset, u64 value);
+    void MarkDirty(u64 offset, u64 size);
+
+    Byaml& byaml;
+    bool checkShared;
+    bool sharedIndexBuilt = false;
+    std::vector<u8> flags; //DataFlags, indexed by offset / 4
+    std::unordered_map<u64, u32> dataOffsets; //64-bit value bits -> an offset holding them, built on first use
+    bool dataOffsetsBuilt = false;
+    std::vector<ByamlDirtyRange> dirtyRanges;
+
+    const char* errorMessage = "No Error";
+    bool isValid = true;
+
+public:
+    ByamlPatch(Byaml& byaml, bool checkShared = true); //Mapped files are remapped copy-on-write, the file itself is never changed
+    bool IsValid() const;
+    const char* GetErrorMessage() const; //Also why the last Set failed
+
+    ByamlView Find(const char* path) const; //First match of a ByamlQuery path
+
+    //The node must be a view of this Byaml with the same type as the value
+    bool SetBool(const ByamlView& node, bool value);
+    bool SetInt(const ByamlView& node, s32 value);
+    bool SetUInt(const ByamlView& node, u32 value);
+    bool SetFloat(const ByamlView& node, float value);
+    bool SetInt64(const ByamlView& node, s64 value); //Shared values are repointed to an existing copy of the new value if there is one
+    bool SetUInt64(const ByamlView& node, u64 value);
+    bool SetDouble(const ByamlView& node, double value);
+    bool SetString(const ByamlView& node, const char* value); //The string must already be in the string table
+
+    const std::vector<ByamlDirtyRange>& GetDirtyRanges() const; //Sorted by offset, overlapping/adjacent ranges merged
+    void ClearDirtyRanges();
+    bool WriteDirty(const char* filePath) const; //Writes only the dirty ranges into 'filePath', which must hold the unpatched file
+};
@@ -0,0 +1,101 @@
+/**
+ *
+ * ByamlQuery.hpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#pragma once
+#include "types.hpp"
+#include "Byaml.hpp"
+#include <string>
+#include <vector>
+#include <functional>
+
+/**
+ * ByamlQuery: a path expression compiled once into steps, then run against a parsed tree or a ByamlView
+ * Segments are separated by '/', a leading "Root" segment is optional:
+ *   key          hash child
+ *   [N]          Nth array element (or hash entry)
+ *   [*]          every child
+ *   [key=value]  every child that is a hash whose 'key' equals value (integer, float, true/false or "string")
+ *   **           this node and all of its descendants
+ * e.g. "Root/[*]/a2fb4a94/[25efa387=0x10000]/a7bb2e42". Matches are streamed to a callback, nothing is collected.
+ */
+
+class ByamlQuery {
+protected:
+    inline void InValidate(const char* message) {
+        this->isValid = false;
+        this->errorMessage = message;
+    }
+
+    enum class StepType : u8 {
+        Key,
+        Index,
+        All,
+        Filter,
+        Descendants
+    };
+
+    enum class ValueType : u8 {
+        Integer,
+        Float,
+        Bool,
+        String
+    };
+
+    struct Step {
+        StepType type;
+        std::string key; //Key, Filter
+        u32 index = 0; //Index
+        ValueType valueType = ValueType::Integer; //Filter
+        s64 intValue = 0;
+        bool intUnsigned = false; //Value only fits in a u64
+        double floatValue = 0;
+        std::string stringValue;
+    };
+
+    bool ParseFilter(Step& step, const std::string& expression);
+    bool ResolveKeys(const Byaml& byaml, u32* outKeyIndices) const;
+
+    std::vector<Step> steps;
+    const char* errorMessage = "No Error";
+    bool isValid = true;
+
+    template <typename Node>
+    static bool MatchValue(const Node& node, const Step& step);
+    template <typename Node, typename Callback>
+    bool RunStep(const u32* keyIndices, u32 stepIndex, u32 depth, const Node& node, const Callback& callback, u64& matchCount) const;
+
+public:
+    static const constexpr u32 MaxSteps = 32;
+
+    ByamlQuery(const char* path);
+    bool IsValid() const;
+    const char* GetErrorMessage() const;
+    u32 GetStepCount() const;
+
+    //Callbacks return false to stop; returns the number of matches handed to the callback
+    u64 Run(const Byaml& byaml, const std::function<bool(const ByamlNode&)>& callback) const; //Byaml must be parsed
+    u64 Run(const Byaml& byaml, const ByamlNode& from, const std::function<bool(const ByamlNode&)>& callback) const;
+    u64 Run(const ByamlView& from, const std::function<bool(const ByamlView&)>& callback) const;
+
+    const ByamlNode* First(const Byaml& byaml) const; //nullptr if nothing matches
+    ByamlView First(const ByamlView& from) const; //Invalid view if nothing matches
+};
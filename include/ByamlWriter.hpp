@@ -0,0 +1,118 @@
+/**
+ *
+ * ByamlWriter.hpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#pragma once
+#include "types.hpp"
+#include "Byaml.hpp"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+struct ByamlWriterNode {
+    NodeType type;
+    u64 value; //Scalar bits, or the string/binary pool index
+    std::vector<u32> array; //Node handles
+    std::vector<std::pair<u32, u32>> hash; //Key pool index -> node handle
+    bool keysAdded; //Hash: Set since the last layout, may hold duplicate keys
+};
+
+/**
+ * ByamlWriter: builds little endian Byaml files (versions 2-4)
+ * Nodes are added first and referenced by handle: scalars, then containers filled with Append/Set.
+ * Writing sorts and deduplicates the key and string tables, and identical containers, 64-bit values and
+ * binaries are written once and shared. Sizes are worked out first, then the file is written in one pass.
+ */
+
+class ByamlWriter {
+protected:
+    inline void InValidate(const char* message) {
+        this->isValid = false;
+        this->errorMessage = message;
+    }
+
+    u32 AddNode(NodeType type, u64 value);
+    u32 ImportNode(const ByamlNode& node);
+    static u32 Intern(std::unordered_map<std::string, u32>& indices, std::vector<std::string>& pool, const char* data, u64 size);
+    bool Check(u32 handle, u32 depth, std::vector<u8>& states, std::vector<bool>& usedKeys, std::vector<bool>& usedStrings);
+    static u64 BuildTable(const std::vector<bool>& used, const std::vector<std::string>& pool, std::vector<u32>& outTable, std::vector<u32>& outIndices);
+    bool IsSameData(u32 a, u32 b) const;
+    void Share(u32 handle);
+    u64 Place(u32 handle, u64 offset);
+    u32 GetDataSize(u32 handle) const;
+    u32 GetValue(u32 handle) const;
+    void WriteTable(u8* out, u32 offset, const std::vector<u32>& table, const std::vector<std::string>& pool) const;
+    void WriteNode(u8* out, u32 handle) const;
+    bool Layout();
+
+    std::vector<ByamlWriterNode> nodes;
+    std::vector<std::string> keyPool, stringPool, binaryPool;
+    std::unordered_map<std::string, u32> keyIndices, stringIndices, binaryIndices; //Contents -> pool index
+    u32 root = static_cast<u32>(-1);
+    u16 version;
+
+    //Filled by Layout
+    bool layoutDirty = true;
+    std::vector<u32> sharedNodes; //Handle -> handle of the identical node that gets written
+    std::vector<u32> sharedSlots; //Hash table of written handles, keyed by dataHashes
+    std::vector<u64> dataHashes; //Handle -> hash of its contents (out-of-line nodes)
+    std::vector<u32> nodeOffsets; //Written handle -> offset of its data
+    std::vector<u32> layoutOrder; //Written handles, by offset
+    std::vector<u32> keyTable, stringTable; //Pool indices sorted by contents
+    std::vector<u32> keyTableIndices, stringTableIndices; //Pool index -> table index
+    u32 keyTableOffset = 0, stringTableOffset = 0;
+    u64 fileSize = 0;
+
+    const char* errorMessage = "No Error";
+    bool isValid = true;
+
+public:
+    ByamlWriter(u16 version = 3);
+    bool IsValid() const;
+    const char* GetErrorMessage() const;
+    u16 GetVersion() const;
+    u32 GetNodeCount() const;
+
+    //Each returns the new node's handle. Int64, UInt64 and Double need version 3+, Binary version 4
+    u32 AddNull();
+    u32 AddBool(bool value);
+    u32 AddInt(s32 value);
+    u32 AddUInt(u32 value);
+    u32 AddFloat(float value);
+    u32 AddInt64(s64 value);
+    u32 AddUInt64(u64 value);
+    u32 AddDouble(double value);
+    u32 AddString(const char* value);
+    u32 AddBinary(const u8* data, u32 size); //Copied
+    u32 AddArray();
+    u32 AddHash();
+    u32 AddNode(const ByamlNode& node); //Deep copy of a parsed node
+
+    //A node can be referenced from any number of containers, but not from itself
+    bool Append(u32 array, u32 value);
+    bool Set(u32 hash, const char* key, u32 value); //Setting an existing key replaces its value
+    bool SetRoot(u32 container);
+
+    u64 GetSize(); //Exact size of the file Write/WriteTo produce, 0 on error
+    bool WriteTo(u8* outBuffer, u64 bufSize);
+    u8* Write(u64& outSize); //Caller takes ownership, free with delete[]
+    bool WriteFile(const char* filePath);
+};
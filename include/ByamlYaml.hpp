@@ -0,0 +1,134 @@
+/**
+ *
+ * ByamlYaml.hpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#pragma once
+#include "types.hpp"
+#include "Byaml.hpp"
+#include "ByamlWriter.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <functional>
+
+typedef std::function<bool(const char* data, u64 size)> ByamlYamlSink; //Return false to stop emitting
+typedef std::function<u64(char* buffer, u64 capacity)> ByamlYamlSource; //Bytes read, 0 at the end of the input
+
+/**
+ * ByamlYamlEmitter: writes a Byaml as YAML, reading it through a ByamlView (no parsed tree needed)
+ * Text goes into a fixed-size buffer that's handed to the sink each time it fills up, so memory use
+ * doesn't grow with the document. Types plain YAML can't tell apart are tagged:
+ * !u (UInt), !l (Int64), !ul (UInt64), !f64 (Double) and !!binary (base64).
+ */
+
+class ByamlYamlEmitter {
+protected:
+    inline void InValidate(const char* message) {
+        this->isValid = false;
+        this->errorMessage = message;
+    }
+
+    bool Flush();
+    void Write(const char* data, u64 size);
+    void WriteChar(char c);
+    void WriteIndent(u32 indent);
+    void WriteString(const char* str, u64 size); //Quoted when it would read back as something else
+    void WriteBase64(const u8* data, u32 size);
+    void WriteScalar(const ByamlView& view);
+    void WriteContainer(const ByamlView& view, u32 indent, bool continueLine, u32 depth);
+    void WriteEntryValue(const ByamlView& view, u32 indent, bool afterDash, u32 depth);
+
+    ByamlYamlSink sink;
+    std::vector<char> buffer;
+    u64 bufferPos = 0;
+
+    const char* errorMessage = "No Error";
+    bool isValid = true;
+
+public:
+    ByamlYamlEmitter(const ByamlYamlSink& sink, u32 bufferSize = 0x10000);
+    bool IsValid() const;
+    const char* GetErrorMessage() const;
+
+    bool Emit(const ByamlView& root); //Flushes before returning
+
+    static ByamlYamlSink FileSink(FILE* file);
+    static ByamlYamlSink FdSink(int fd);
+    static ByamlYamlSink StringSink(std::string& outStr); //Appends
+};
+
+/**
+ * ByamlYamlParser: reads YAML into a ByamlWriter, one line at a time
+ * Input is pulled from the source in chunks, only the current line is kept. Supports block mappings and
+ * sequences, single-line flow collections, quoted strings and the tags ByamlYamlEmitter writes.
+ * Anchors, aliases and block scalars (| and >) aren't supported.
+ */
+
+class ByamlYamlParser {
+protected:
+    inline void InValidate(const char* message) {
+        this->isValid = false;
+        this->errorMessage = message;
+    }
+
+    struct Frame {
+        u32 handle;
+        u32 indent; //Column of the container's entries
+        bool isArray;
+    };
+
+    bool ParseLine(const char* line, const char* end);
+    bool ParseEntry(u32 indent, const char* p, const char* end);
+    bool Attach(u32 parent, bool parentIsArray, const std::string& key, u32 value);
+    bool ParseKey(const char*& p, const char* end, bool inFlow, std::string& outKey);
+    bool ParseQuoted(const char*& p, const char* end, std::string& outStr);
+    u32 ParseValue(const char*& p, const char* end, bool inFlow, u32 depth);
+    u32 ParseTagged(const std::string& tag, const std::string& text, bool quoted);
+    u32 ParsePlain(const char* text, u64 size);
+
+    ByamlWriter writer;
+    std::vector<Frame> stack;
+    bool hasRoot = false;
+    bool isFinished = false; //Document end marker seen
+
+    //A "key:" or "-" with nothing after it, waiting for the next line to tell what its value is
+    bool hasPending = false;
+    u32 pendingParent = 0;
+    bool pendingParentIsArray = false;
+    u32 pendingIndent = 0;
+    std::string pendingKey;
+
+    u32 lineNumber = 0;
+    const char* errorMessage = "No Error";
+    bool isValid = true;
+
+public:
+    ByamlYamlParser(u16 version = 3); //Byaml version of the output, 3+ for !l, !ul and !f64, 4 for !!binary
+    bool IsValid() const;
+    const char* GetErrorMessage() const;
+    u32 GetErrorLine() const; //Line the error was found on, 0 if none
+
+    bool Parse(const ByamlYamlSource& source);
+    bool ParseFile(const char* filePath);
+    bool ParseString(const char* text, u64 size);
+
+    ByamlWriter& GetWriter(); //Holds the parsed document, write it out with Write/WriteFile
+};
@@ -0,0 +1,78 @@
+/**
+ *
+ * CorpusGen.hpp
+ *
+ * Copyright (c) 2021-2025, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#pragma once
+#include "types.hpp"
+#include "MSBT.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * CorpusGen: synthetic, valid files for benchmarks and stress tests, as game files can't be shipped
+ * Layouts match what the parsers expect from ACNH 1.5.0+ files. All output is deterministic for a given seed.
+ */
+
+struct SARCGenParams {
+    u32 fileCount = 100; //Clamped to the SFAT limit of 0x3FFF
+    u32 fileSize = 0x400;
+    bool bigEndian = false; //BOM 0xFEFF, as in Wii U and older archives
+    u32 seed = 0;
+};
+
+struct BCSVGenParams {
+    u32 rowCount = 1000;
+    u16 columnCount = 7; //Cycles through u32, string, u32, float, u8, u8, u16 columns, so the default has one of each type
+    u8 version = 1; //0 or 1
+    u32 seed = 0;
+};
+
+struct ByamlGenParams {
+    u16 version = 3; //1-4, 64-bit nodes (Int64, UInt64, Double) are only written for version 3+
+    u32 depth = 3; //Container levels below the root
+    u32 fanOut = 8; //Children per container
+    u32 keyCount = 64; //Unique hash keys
+    u32 stringCount = 256; //Unique string values
+    bool bigEndian = false; //"BY" files, as in Wii U and older games
+    u32 seed = 0;
+};
+
+struct MSBTGenParams {
+    u32 entryCount = 1000;
+    u32 textLength = 32; //Characters per text, excluding the terminator
+    MSBTEncoding encoding = Encoding_UTF16;
+    u32 seed = 0;
+};
+
+namespace CorpusGen {
+    std::vector<u8> MakeSARC(const SARCGenParams& params);
+    std::vector<u8> MakeZstdFrame(const std::vector<u8>& data); //Uncompressed (raw) blocks, valid for ACNHSarc
+    std::vector<u8> MakeBCSV(const BCSVGenParams& params);
+    std::vector<u8> MakeByaml(const ByamlGenParams& params);
+    std::vector<u8> MakeSaveLayoutByaml(u32 typeCount, u32 memberCount, bool bigEndian = false); //Same shape as romfs:/System/Smmh, see ACNHByaml
+    std::vector<u8> MakeMSBT(const MSBTGenParams& params);
+    std::vector<u8> MakeBFTTF(u32 fontSize);
+
+    std::string SARCFileName(u32 index);
+    std::string BCSVColumnName(u16 index); //CRC32 of this is the column hash
+    std::string MSBTLabel(u32 index);
+    bool WriteFile(const std::string& filePath, const std::vector<u8>& data);
+}
@@ -0,0 +1,103 @@
+/**
+ *
+ * Endian.hpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+
+#pragma once
+#include "types.hpp"
+#include <cstring>
+
+/**
+ * Endian: unaligned reads (and writes) of file data in a fixed byte order
+ * The byte order is a template argument, so parsers instantiated for one order get plain loads
+ * (plus a byte swap for big endian) with no per-read branch. Hosts are little endian.
+ */
+
+namespace Endian {
+    template<bool BigEndian>
+    ALWAYS_INLINE u16 ReadU16(const void* address) {
+        u16 val;
+        memcpy(&val, address, sizeof(val));
+        return BigEndian ? __builtin_bswap16(val) : val;
+    }
+
+    template<bool BigEndian>
+    ALWAYS_INLINE u32 ReadU24(const void* address) {
+        const u8* bytes = static_cast<const u8*>(address);
+        if (BigEndian)
+            return (static_cast<u32>(bytes[0]) << 16) | (static_cast<u32>(bytes[1]) << 8) | bytes[2];
+        return bytes[0] | (static_cast<u32>(bytes[1]) << 8) | (static_cast<u32>(bytes[2]) << 16);
+    }
+
+    template<bool BigEndian>
+    ALWAYS_INLINE u32 ReadU32(const void* address) {
+        u32 val;
+        memcpy(&val, address, sizeof(val));
+        return BigEndian ? __builtin_bswap32(val) : val;
+    }
+
+    template<bool BigEndian>
+    ALWAYS_INLINE u64 ReadU64(const void* address) {
+        u64 val;
+        memcpy(&val, address, sizeof(val));
+        return BigEndian ? __builtin_bswap64(val) : val;
+    }
+
+    template<bool BigEndian>
+    ALWAYS_INLINE s32 ReadS32(const void* address) {
+        return static_cast<s32>(ReadU32<BigEndian>(address));
+    }
+
+    template<bool BigEndian>
+    ALWAYS_INLINE s64 ReadS64(const void* address) {
+        return static_cast<s64>(ReadU64<BigEndian>(address));
+    }
+
+    template<bool BigEndian>
+    ALWAYS_INLINE float ReadFloat(const void* address) { //Bits, not a value conversion
+        u32 val = ReadU32<BigEndian>(address);
+        float result;
+        memcpy(&result, &val, sizeof(result));
+        return result;
+    }
+
+    template<bool BigEndian>
+    ALWAYS_INLINE double ReadDouble(const void* address) {
+        u64 val = ReadU64<BigEndian>(address);
+        double result;
+        memcpy(&result, &val, sizeof(result));
+        return result;
+    }
+
+    template<bool BigEndian>
+    ALWAYS_INLINE void WriteU32(void* address, u32 val) {
+        if (BigEndian)
+            val = __builtin_bswap32(val);
+        memcpy(address, &val, sizeof(val));
+    }
+
+    template<bool BigEndian>
+    ALWAYS_INLINE void WriteU64(void* address, u64 val) {
+        if (BigEndian)
+            val = __builtin_bswap64(val);
+        memcpy(address, &val, sizeof(val));
+    }
+}
@@ -77,6 +77,7 @@ protected:
     u64 dataSize = 0;
     const char* errorMessage = "No Error";
     bool autoManageMem = false;
+    bool autoUnmapMem = false;
 
     bool bigEndian = false;
     bool isValid = true;
@@ -87,7 +88,7 @@ protected:
     std::map<std::string, std::string> stringMap;
 
 public:
-    MSBT(const char *filePath);
+    MSBT(const char *filePath, bool mapFile = false);
     MSBT(u8 *inBuffer, u64 bufSize, bool manageMem = false);
     virtual ~MSBT();
     bool IsValid() const;
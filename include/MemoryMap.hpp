@@ -0,0 +1,36 @@
+/**
+ *
+ * MemoryMap.hpp
+ *
+ * Copyright (c) 2021-2025, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#pragma once
+#include "types.hpp"
+
+/**
+ * MemoryMap: read-only, private file mappings used by the file constructors
+ * Only available on POSIX platforms; IsSupported() returns false elsewhere and Map() always fails
+ */
+
+namespace MemoryMap {
+    bool IsSupported();
+    u8* Map(const char* filePath, u64& outSize); //Returns nullptr on failure
+    void Unmap(u8* address, u64 size);
+    bool MakeWritable(u8* address, u64 size); //Writes stay private to the mapping (copy-on-write), the file is untouched
+}
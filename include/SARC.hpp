@@ -22,9 +22,11 @@
 
 #pragma once
 #include "types.hpp"
+#include "Endian.hpp"
 #include <vector>
 
 struct SARCFileInfo {
+    u32 nameHash;
     const char* name;
     u8* dataAddress;
     u32 dataSize;
@@ -39,29 +41,18 @@ protected:
         this->errorMessage = message;
     }
 
-    ALWAYS_INLINE u16 ReadU16(void *address) const
-    {
-        u16 val = *(u16 *)(address);
-        if (bigEndian)
-            return __builtin_bswap16(val);
-        return val;
-    }
-
-    ALWAYS_INLINE u32 ReadU32(void *address) const
-    {
-        u32 val = *(u32 *)(address);
-        if (bigEndian)
-            return __builtin_bswap32(val);
-        return val;
-    }
-
     void Init();
-    void Parse();
+    template<bool BigEndian> void InitTables();
+    template<bool BigEndian> void Parse();
+    const SARCFileInfo* FindFile(u32 nameHash) const;
+    const SARCFileInfo* FindFile(const char* sarcFilePath) const;
+    virtual bool LoadFile(const SARCFileInfo& info); //Makes sure a file's data is available before it's handed out
 
     u8 *data = nullptr;
     u64 dataSize = 0;
     const char *errorMessage = "No Error";
     bool autoManageMem = false;
+    bool autoUnmapMem = false;
 
     bool bigEndian = false;
     bool isValid = true;
@@ -69,17 +60,36 @@ protected:
     u32 nameTableAddress = 0;
     u32 nodeAddress = 0;
     u16 nodeCount = 0;
+    u32 hashKey = 0x65;
 
     std::vector<SARCFileInfo> fileInfo;
 
 public:
     SARC();
-    SARC(const char *filePath);
+    SARC(const char *filePath, bool mapFile = false);
     SARC(u8 *inBuffer, u64 bufSize, bool manageMem = false);
     virtual ~SARC();
     bool IsValid() const;
     const char *GetErrorMessage() const;
+    bool IsBigEndian() const; //Wii U and older archives (BOM 0xFEFF)
 
     void Print();
     bool GetFile(const char* outFile, const char* sarcFilePath);
+
+    //In-memory access, dataAddress points directly into the archive (no copies)
+    bool GetFileInfo(SARCFileInfo& outInfo, const char* sarcFilePath);
+    bool GetFileInfoByHash(SARCFileInfo& outInfo, u32 nameHash);
+    bool GetFileInfoByIndex(SARCFileInfo& outInfo, u32 index); //Index order is SFAT (hash) order
+    u32 GetFileCount() const;
+    u32 GetHashKey() const;
+
+    //Same hash the SFAT nodes are sorted by; hashKey is stored in the SFAT header (0x65 in all known files)
+    static LIBACNH_CONSTEXPR u32 CalcNameHash(const char* name, u32 hashKey = 0x65) {
+        u32 hash = 0;
+        while (*name != '\0') {
+            hash = (hash * hashKey) + static_cast<u32>(static_cast<s8>(*name)); //Characters are sign-extended
+            name++;
+        }
+        return hash;
+    }
 };
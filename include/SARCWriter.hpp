@@ -0,0 +1,90 @@
+/**
+ *
+ * SARCWriter.hpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#pragma once
+#include "types.hpp"
+#include "SARC.hpp"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+struct SARCWriterEntry {
+    std::string name;
+    u32 nameHash;
+    const u8* data; //Not owned, must stay valid until the archive is written
+    u32 dataSize;
+    u32 alignment;
+};
+
+/**
+ * SARCWriter: builds little endian SARC archives (ACNH layout)
+ * Nodes are sorted by name hash, names are 4-byte aligned in SFNT and each file's data is aligned
+ * for its type. File data is only read while writing, straight into the output buffer/file.
+ */
+
+class SARCWriter {
+protected:
+    inline void InValidate(const char* message) {
+        this->isValid = false;
+        this->errorMessage = message;
+    }
+
+    bool Layout();
+    void WriteHeaders(u8* out) const;
+
+    std::vector<SARCWriterEntry> entries;
+    std::unordered_map<std::string, u32> entryIndices; //name -> entries index
+    u32 hashKey = 0x65;
+
+    //Filled by Layout
+    bool layoutDirty = true;
+    std::vector<u32> nameOffsets;
+    std::vector<u32> dataBegins;
+    u32 headersSize = 0; //SARC + SFAT + SFNT, before padding
+    u32 dataOffset = 0;
+    u64 archiveSize = 0;
+
+    const char* errorMessage = "No Error";
+    bool isValid = true;
+
+public:
+    SARCWriter(u32 hashKey = 0x65);
+    bool IsValid() const;
+    const char* GetErrorMessage() const;
+
+    //Adding an existing name replaces its data. alignment 0 == pick from the name/data (GetDefaultAlignment)
+    bool AddFile(const char* name, const u8* data, u32 dataSize, u32 alignment = 0);
+    bool AddFiles(SARC& sarc); //Repack: every file of 'sarc', which must outlive the writer
+    bool RemoveFile(const char* name);
+    u32 GetFileCount() const;
+
+    u64 GetSize(); //Exact size of the archive Write/WriteTo produce
+    bool WriteTo(u8* outBuffer, u64 bufSize);
+    u8* Write(u64& outSize); //Caller takes ownership, free with delete[]
+    bool WriteFile(const char* filePath);
+
+    //zstd frame of the archive, readable by ACNHSarc (see ZstdStream::WriteFrame)
+    u8* WriteCompressed(u64& outSize, int level = 3); //Caller takes ownership, free with delete[]
+    bool WriteCompressedFile(const char* filePath, int level = 3);
+
+    static u32 GetDefaultAlignment(const char* name, const u8* data, u32 dataSize);
+};
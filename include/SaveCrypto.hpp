@@ -48,5 +48,5 @@ static_assert((sizeof(GSaveVersion) == 0x300), "GSaveVersion is not 0x300 in siz
 namespace SaveCrypto {
     void RegenHeaderCrypto(GSaveVersion& header);
     void RegenHeaderCrypto(GSaveVersion& header, const u32 seed);
-    void Crypt(const GSaveVersion& header, u8* encryptedSave, const u32 saveSize);
+    bool Crypt(const GSaveVersion& header, u8* encryptedSave, const u32 saveSize); //false if the AES backend failed, the save may be partially crypted
 }
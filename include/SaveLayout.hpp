@@ -0,0 +1,85 @@
+/**
+ *
+ * SaveLayout.hpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#pragma once
+#include "types.hpp"
+#include <cstddef>
+
+/**
+ * SaveLayout: compile-time save field tables, generated from a layout .byml by acnh_layoutgen
+ * Each generated header holds one namespace per game version, e.g. SaveLayout::v2_0_0::Fields,
+ * with Offset<"Player.Pocket1">() / Size<...>() (C++20) resolving to constants with no byml parsing.
+ */
+
+struct SaveLayoutField {
+    const char* path; //Dotted member names from the root type, e.g. "Player.Pocket1"
+    u64 offset; //Sum of the member offsets along the path
+    u64 size; //Size of the last member
+};
+
+namespace SaveLayout {
+    LIBACNH_CONSTEXPR bool PathEquals(const char* a, const char* b) {
+        while (*a != '\0' && *a == *b) {
+            a++;
+            b++;
+        }
+        return *a == *b;
+    }
+
+    template <size_t N>
+    LIBACNH_CONSTEXPR const SaveLayoutField* Find(const SaveLayoutField (&fields)[N], const char* path) { //nullptr if missing
+        for (size_t i = 0; i < N; i++) {
+            if (PathEquals(fields[i].path, path))
+                return &fields[i];
+        }
+        return nullptr;
+    }
+
+#if __cplusplus > 201703L
+    template <size_t N>
+    struct Path { //String literal usable as a template argument
+        char value[N];
+
+        consteval Path(const char (&str)[N]) {
+            for (size_t i = 0; i < N; i++)
+                value[i] = str[i];
+        }
+    };
+
+    //Unknown paths fail to compile (a throw isn't allowed in constant evaluation)
+    template <Path path, size_t N>
+    consteval u64 GetOffset(const SaveLayoutField (&fields)[N]) {
+        const SaveLayoutField* field = Find(fields, path.value);
+        if (field == nullptr)
+            throw "Unknown save layout field";
+        return field->offset;
+    }
+
+    template <Path path, size_t N>
+    consteval u64 GetSize(const SaveLayoutField (&fields)[N]) {
+        const SaveLayoutField* field = Find(fields, path.value);
+        if (field == nullptr)
+            throw "Unknown save layout field";
+        return field->size;
+    }
+#endif
+}
@@ -0,0 +1,93 @@
+/**
+ *
+ * ZstdStream.hpp
+ *
+ * Copyright (c) 2021-2025, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#pragma once
+#include "types.hpp"
+#include <cstdio>
+
+typedef struct ZSTD_DCtx_s ZSTD_DCtx;
+
+/**
+ * ZstdStream: streaming zstd decompression into a single output buffer
+ * Input is either memory mapped, read in small chunks, or a caller-owned buffer.
+ * Decompression contexts are pooled per thread, so back-to-back streams skip context setup.
+ * WriteFrame compresses with the system zstd when built with LIBACNH_SYSTEM_ZSTD, otherwise
+ * (the bundled library only decodes) it writes stored blocks any zstd decoder can read.
+ */
+
+class ZstdStream {
+protected:
+    inline void InValidate(const char* message) {
+        this->isValid = false;
+        this->errorMessage = message;
+    }
+
+    void Init();
+    bool ReadInput();
+    bool GrowOutput();
+    void Finish();
+
+    FILE* file = nullptr;
+    u8* mappedData = nullptr;
+    u64 mappedSize = 0;
+    u8* inBuffer = nullptr;
+    u64 inCapacity = 0;
+    const u8* srcData = nullptr;
+    u64 srcSize = 0;
+    u64 srcPos = 0;
+
+    ZSTD_DCtx* ctx = nullptr;
+    u8* outData = nullptr;
+    u64 outCapacity = 0;
+    u64 outPos = 0;
+    u64 contentSize = 0;
+    bool contentSizeKnown = false;
+    bool isFinished = false;
+
+    const char* errorMessage = "No Error";
+    bool isValid = true;
+
+public:
+    ZstdStream(const char* filePath);
+    ZstdStream(const u8* inBuffer, u64 bufSize); //inBuffer must outlive the stream
+    ZstdStream(const ZstdStream&) = delete;
+    ZstdStream& operator=(const ZstdStream&) = delete;
+    ~ZstdStream();
+    bool IsValid() const;
+    const char* GetErrorMessage() const;
+
+    bool Decompress(u64 size); //Decompresses until at least 'size' bytes are available (or the frame ends)
+    bool DecompressAll();
+    bool IsFinished() const;
+    bool IsContentSizeKnown() const;
+
+    u8* GetData() const; //Only stable once the content size is known, or after DecompressAll
+    u64 GetContentSize() const;
+    u64 GetDecompressedSize() const;
+    u8* Release(u64& outSize); //Caller takes ownership, free with delete[]
+
+    static ZSTD_DCtx* AcquireContext();
+    static void ReleaseContext(ZSTD_DCtx* dctx);
+
+    static u64 GetFrameBound(u64 srcSize); //Largest frame WriteFrame can produce for srcSize bytes
+    static u64 WriteFrame(u8* outBuffer, u64 outCapacity, const u8* src, u64 srcSize, int level = 3); //Level 0 == stored blocks, returns 0 on failure
+};
@@ -23,12 +23,18 @@
 #include "ACNHByaml.hpp"
 #include <cstring>
 
-ACNHByaml::ACNHByaml(const char* filePath) : Byaml(filePath) {
-
+static const char* const KeyName = "25efa387";
+static const char* const KeyTypeName = "5c65d8b5";
+static const char* const KeyMembers = "a2fb4a94";
+static const char* const KeyOffset = "a7bb2e42";
+static const char* const KeySize = "b4a58247";
+
+ACNHByaml::ACNHByaml(const char* filePath, bool mapFile) : Byaml(filePath, mapFile) {
+    BuildIndex();
 }
 
 ACNHByaml::ACNHByaml(u8* inBuffer, u64 bufSize, bool manageMem) : Byaml(inBuffer, bufSize, manageMem) {
-
+    BuildIndex();
 }
 
 ACNHByaml::~ACNHByaml() {
@@ -39,170 +45,107 @@ ACNHByaml::~ACNHByaml() {
 }
 
 //Path: Array -> Hash -> Array -> Hash
-u64 ACNHByaml::CalcOffset(u32& typeName, u32 fieldName) {
-    u32 typeUInt = 0;
-    u64 res = 0;
-
-    if (!IsTypeArray(parentNode.type) || !IsValid())
-        return 0;
-    
+//Same rules as the old per-lookup scan: first matching type/member wins and a member's TypeName is only taken when it's a UInt
+void ACNHByaml::BuildIndex() {
+    if (!IsValid() || !IsTypeArray(parentNode.type))
+        return;
+
+    u32 keyName = 0, keyTypeName = 0, keyMembers = 0, keyOffset = 0, keySize = 0;
+    bool hasName = GetKeyIndex(KeyName, keyName);
+    bool hasTypeName = GetKeyIndex(KeyTypeName, keyTypeName);
+    bool hasMembers = GetKeyIndex(KeyMembers, keyMembers);
+    bool hasOffset = GetKeyIndex(KeyOffset, keyOffset);
+    bool hasSize = GetKeyIndex(KeySize, keySize);
+    if (!hasName || !hasTypeName || !hasMembers)
+        return;
+
+    u64 memberCount = 0;
     for (u64 i = 0; i < parentNode.size; i++) {
-        ByamlNode arrayNode = (*parentNode.array)[i];
-        
-        if (IsTypeHash(arrayNode.type)) {
-            for (auto elem : (*arrayNode.hash)) {
-                if (strcmp(elem.first, "5c65d8b5") == 0 && elem.second.type == NodeType::UInt) { //5c65d8b5 == "TypeName"
-                    typeUInt = elem.second.UInt;
-                }
-                
-                else if (typeUInt == typeName && strcmp(elem.first, "a2fb4a94") == 0 && IsTypeArray(elem.second.type)) { //a2fb4a94 == "Members"
-                    ByamlNode secElem = elem.second;
-                    
-                    for (u64 j = 0; j < secElem.size; j++) {
-                        ByamlNode arrayNode2 = (*secElem.array)[j];
-                        
-                        if (IsTypeHash(arrayNode2.type)) {
-                            bool found = false;
-                            for (auto elem2 : (*arrayNode2.hash)) {
-                                if (strcmp(elem2.first, "25efa387") == 0 && elem2.second.type == NodeType::UInt) { //25efa387 == "Name"
-                                    found = (fieldName == elem2.second.UInt);
-                                }
-                                
-                                else if (found && strcmp(elem2.first, "5c65d8b5") == 0 && elem2.second.type == NodeType::UInt) { //5c65d8b5 == "TypeName"
-                                    typeName = elem2.second.UInt;
-                                }
-                                
-                                else if (found && strcmp(elem2.first, "a7bb2e42") == 0 && elem2.second.type == NodeType::Int64) { //a7bb2e42 == "Offset"
-                                    res = (u64)elem2.second.Int64;
-                                }
-
-                                if (found && typeName != typeUInt && res != 0) //Assume offset found, break early
-                                    break;
-                            }
-                            
-                            if (found) {
-                                return res;
-                            }
-                        }
-                    }
-                }
-            }
-        }
+        const ByamlNode* membersNode = parentNode.array[i].GetByKeyIndex(keyMembers);
+        if (membersNode != nullptr && IsTypeArray(membersNode->type))
+            memberCount += membersNode->size;
     }
+    members.reserve(memberCount);
+    memberIndices.reserve(memberCount);
 
-    return 0;
-}
-
-//Path: Array -> Hash -> Array -> Hash
-u64 ACNHByaml::GetSize(u32& typeName, u32 fieldName) {
-    u32 typeUInt = 0;
-    u64 res = 0;
-
-    if (!IsTypeArray(parentNode.type) || !IsValid())
-        return 0;
-    
+    u32 typeUInt = 0; //Carries over to types without a TypeName, like the original scan
     for (u64 i = 0; i < parentNode.size; i++) {
-        ByamlNode arrayNode = (*parentNode.array)[i];
-        
-        if (IsTypeHash(arrayNode.type)) {
-            for (auto elem : (*arrayNode.hash)) {
-                if (strcmp(elem.first, "5c65d8b5") == 0 && elem.second.type == NodeType::UInt) { //5c65d8b5 == "TypeName"
-                    typeUInt = elem.second.UInt;
-                }
-                else if (typeUInt == typeName && strcmp(elem.first, "a2fb4a94") == 0 && IsTypeArray(elem.second.type)) { //a2fb4a94 == "Members"
-                    ByamlNode secElem = elem.second;
-                    
-                    for (u64 j = 0; j < secElem.size; j++) {
-                        ByamlNode arrayNode2 = (*secElem.array)[j];
-                        
-                        if (IsTypeHash(arrayNode2.type)) {
-                            bool found = false;
-                            for (auto elem2 : (*arrayNode2.hash)) {
-                                if (strcmp(elem2.first, "25efa387") == 0 && elem2.second.type == NodeType::UInt) { //25efa387 == "Name"
-                                    found = (fieldName == elem2.second.UInt);
-                                }
-                                
-                                else if (found && strcmp(elem2.first, "5c65d8b5") == 0 && elem2.second.type == NodeType::UInt) { //5c65d8b5 == "TypeName"
-                                     typeName = elem2.second.UInt;
-                                }
-
-                                else if (found && strcmp(elem2.first, "b4a58247") == 0 && elem2.second.type == NodeType::Int64) { //b4a58247 == "Size"
-                                    res = (u64)elem2.second.Int64;
-                                }
-
-                                if (found && typeName != typeUInt && res != 0) //Assume size found, break early
-                                    break;
-                            }
-                            
-                            if (found) {
-                                return res;
-                            }
-                        }
-                    }
-                }
-            }
+        const ByamlNode& typeNode = parentNode.array[i];
+        if (!IsTypeHash(typeNode.type))
+            continue;
+
+        const ByamlNode* typeNameNode = typeNode.GetByKeyIndex(keyTypeName);
+        if (typeNameNode != nullptr && typeNameNode->type == NodeType::UInt)
+            typeUInt = typeNameNode->UInt;
+
+        const ByamlNode* membersNode = typeNode.GetByKeyIndex(keyMembers);
+        if (membersNode == nullptr || !IsTypeArray(membersNode->type))
+            continue;
+
+        for (u64 j = 0; j < membersNode->size; j++) {
+            const ByamlNode& memberNode = membersNode->array[j];
+            if (!IsTypeHash(memberNode.type))
+                continue;
+
+            const ByamlNode* nameNode = memberNode.GetByKeyIndex(keyName);
+            if (nameNode == nullptr || nameNode->type != NodeType::UInt)
+                continue;
+
+            ACNHByamlMember member;
+            member.typeName = typeUInt;
+            member.name = nameNode->UInt;
+            member.memberTypeName = typeUInt;
+            member.offset = 0;
+            member.size = 0;
+            member.node = &memberNode;
+
+            const ByamlNode* valueNode = memberNode.GetByKeyIndex(keyTypeName);
+            if (valueNode != nullptr && valueNode->type == NodeType::UInt)
+                member.memberTypeName = valueNode->UInt;
+
+            valueNode = hasOffset ? memberNode.GetByKeyIndex(keyOffset) : nullptr;
+            if (valueNode != nullptr && valueNode->type == NodeType::Int64)
+                member.offset = static_cast<u64>(valueNode->Int64);
+
+            valueNode = hasSize ? memberNode.GetByKeyIndex(keySize) : nullptr;
+            if (valueNode != nullptr && valueNode->type == NodeType::Int64)
+                member.size = static_cast<u64>(valueNode->Int64);
+
+            if (memberIndices.emplace(MemberKey(member.typeName, member.name), static_cast<u32>(members.size())).second)
+                members.push_back(member);
         }
     }
-
-    return 0;
 }
 
+const ACNHByamlMember* ACNHByaml::FindMember(u32 typeName, u32 fieldName) const {
+    auto it = memberIndices.find(MemberKey(typeName, fieldName));
+    if (it == memberIndices.end())
+        return nullptr;
 
-//Path: Array -> Hash -> Array -> Hash
-ByamlNode ACNHByaml::GetNode(u32& typeName, u32 fieldName) {
-    u32 typeUInt = 0;
-    ByamlNode res = ByamlNode();
+    return &members[it->second];
+}
 
-    if (!IsTypeArray(parentNode.type) || !IsValid())
-        return ByamlNode();
-    
-    for (u64 i = 0; i < parentNode.size; i++) {
-        ByamlNode arrayNode = (*parentNode.array)[i];
-        
-        if (IsTypeHash(arrayNode.type)) {
-            for (auto elem : (*arrayNode.hash)) {
-                if (strcmp(elem.first, "5c65d8b5") == 0 && elem.second.type == NodeType::UInt) { //5c65d8b5 == "TypeName"
-                    typeUInt = elem.second.UInt;
-                }
-                else if (typeUInt == typeName && strcmp(elem.first, "a2fb4a94") == 0 && IsTypeArray(elem.second.type)) { //a2fb4a94 == "Members"
-                    ByamlNode secElem = elem.second;
-                    
-                    for (u64 j = 0; j < secElem.size; j++) {
-                        ByamlNode arrayNode2 = (*secElem.array)[j];
-                        
-                        if (IsTypeHash(arrayNode2.type)) {
-                            bool found = false;
-                            res = arrayNode2;
-                            for (auto elem2 : (*arrayNode2.hash)) {
-                                if (strcmp(elem2.first, "25efa387") == 0 && elem2.second.type == NodeType::UInt) { //25efa387 == "Name"
-                                    found = (fieldName == elem2.second.UInt);
-                                }
-                                else if (found && strcmp(elem2.first, "5c65d8b5") == 0 && elem2.second.type == NodeType::UInt) { //5c65d8b5 == "TypeName"
-                                     typeName = elem2.second.UInt;
-                                }
-
-                                if (found && typeName != typeUInt) //Assume size found, break early
-                                    break;
-                            }
-                            
-                            if (found) {
-                                return res;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
+bool ACNHByaml::GetMember(u32 typeName, u32 fieldName, ACNHByamlMember& outMember) const {
+    const ACNHByamlMember* member = FindMember(typeName, fieldName);
+    if (member == nullptr)
+        return false;
 
-    return ByamlNode();
+    outMember = *member;
+    return true;
 }
 
+u32 ACNHByaml::GetMemberCount() const {
+    return static_cast<u32>(members.size());
+}
 
 u64 ACNHByaml::CalcOffsets(u32 fieldType, const std::vector<u32>& fieldNames) {
     u64 offset = 0;
     for (u32 name : fieldNames) {
-        offset += CalcOffset(fieldType, name);
+        const ACNHByamlMember* member = FindMember(fieldType, name);
+        if (member != nullptr) {
+            offset += member->offset;
+            fieldType = member->memberTypeName;
+        }
     }
     return offset;
 }
@@ -210,7 +153,12 @@ u64 ACNHByaml::CalcOffsets(u32 fieldType, const std::vector<u32>& fieldNames) {
 u64 ACNHByaml::GetSize(u32 fieldType, const std::vector<u32>& fieldNames) {
     u64 size = 0;
     for (u32 name : fieldNames) {
-        size = GetSize(fieldType, name);
+        const ACNHByamlMember* member = FindMember(fieldType, name);
+        size = 0;
+        if (member != nullptr) {
+            size = member->size;
+            fieldType = member->memberTypeName;
+        }
     }
     return size;
 }
@@ -218,7 +166,12 @@ u64 ACNHByaml::GetSize(u32 fieldType, const std::vector<u32>& fieldNames) {
 ByamlNode ACNHByaml::GetNode(u32 fieldType, const std::vector<u32>& fieldNames) {
     ByamlNode node = ByamlNode();
     for (u32 name : fieldNames) {
-        node = GetNode(fieldType, name);
+        const ACNHByamlMember* member = FindMember(fieldType, name);
+        node = ByamlNode();
+        if (member != nullptr) {
+            node = *member->node;
+            fieldType = member->memberTypeName;
+        }
     }
     return node;
-}
\ No newline at end of file
+}
@@ -23,7 +23,7 @@
 #include "ACNHItemMsbt.hpp"
 #include <cstring>
 
-ACNHItemMsbt::ACNHItemMsbt(const char* filePath) : MSBT(filePath) {
+ACNHItemMsbt::ACNHItemMsbt(const char* filePath, bool mapFile) : MSBT(filePath, mapFile) {
     if (IsValid())
         FixItemNames();
 }
@@ -21,38 +21,25 @@
  */
 
 #include "ACNHSarc.hpp"
-#include "zstd.h"
-#include <cstdio>
+#include "ZstdStream.hpp"
 
-ACNHSarc::ACNHSarc(const char* filePath) {
-    FILE* file = fopen(filePath, "r");
-    if (file == NULL) {
-        InValidate("ACNHSarc: Failed to open file");
+static const constexpr u32 SARCHeaderSize = 0x14;
+
+ACNHSarc::ACNHSarc(const char* filePath, bool lazy) {
+    if (lazy) {
+        this->InitLazy(filePath);
         return;
     }
 
-    fseek(file, 0, SEEK_END);
-    u64 dataSize = ftell(file);
-    rewind(file);
-    u8* srcData = new u8[dataSize];
-    size_t res = fread(srcData, sizeof(u8), dataSize, file);
-    fclose(file);
-
-    if (res == dataSize) {
-        u64 destSize = ZSTD_getFrameContentSize(srcData, dataSize);
-        this->data = new u8[destSize];
-        this->autoManageMem = true;
-
-        size_t retSize = ZSTD_decompress(this->data, destSize, srcData, dataSize);
-        if (!ZSTD_isError(retSize)) {
-            this->Init();
-        }
-        else {
-            InValidate("ACNHSarc: ZSTD Error");
-        }
+    ZstdStream stream(filePath);
+    if (!stream.DecompressAll()) {
+        InValidate(stream.GetErrorMessage());
+        return;
     }
-    
-    delete[] srcData;
+
+    this->data = stream.Release(this->dataSize);
+    this->autoManageMem = true;
+    this->Init();
 }
 
 ACNHSarc::~ACNHSarc() {
@@ -60,4 +47,70 @@ ACNHSarc::~ACNHSarc() {
         delete[] this->data;
         autoManageMem = false;
     }
+
+    delete this->stream;
+    this->stream = nullptr;
+    this->data = nullptr;
+}
+
+void ACNHSarc::InitLazy(const char* filePath) {
+    this->stream = new ZstdStream(filePath);
+    if (!stream->IsValid()) {
+        InValidate(stream->GetErrorMessage());
+        return;
+    }
+
+    if (!stream->IsContentSizeKnown()) { //Output buffer may move while growing, so decompress everything
+        if (!stream->DecompressAll()) {
+            InValidate(stream->GetErrorMessage());
+            return;
+        }
+    }
+
+    if (!stream->Decompress(SARCHeaderSize) || stream->GetDecompressedSize() < SARCHeaderSize) {
+        InValidate(stream->IsValid() ? "ACNHSarc: File too small" : stream->GetErrorMessage());
+        return;
+    }
+
+    //Everything up to the data offset is SFAT + SFNT, which is all Init/Parse need
+    u8* header = stream->GetData();
+    bool bigEndianBOM = header[6] == 0xFE && header[7] == 0xFF;
+    u32 tableEnd = bigEndianBOM ? Endian::ReadU32<true>(header + 0xC) : Endian::ReadU32<false>(header + 0xC);
+
+    if (tableEnd > stream->GetContentSize()) {
+        InValidate("ACNHSarc: Data Offset Past End Of File");
+        return;
+    }
+
+    if (!stream->Decompress(tableEnd)) {
+        InValidate(stream->GetErrorMessage());
+        return;
+    }
+
+    this->data = stream->GetData();
+    this->dataSize = stream->GetContentSize();
+    this->Init();
+}
+
+bool ACNHSarc::LoadFile(const SARCFileInfo& info) {
+    if (this->stream == nullptr)
+        return true;
+
+    u64 fileEnd = static_cast<u64>(info.dataAddress - this->data) + info.dataSize;
+    if (fileEnd > this->dataSize) {
+        return false;
+    }
+
+    if (!stream->Decompress(fileEnd)) { //No-op when already below the decompressed high-water mark
+        InValidate(stream->GetErrorMessage());
+        return false;
+    }
+    return true;
+}
+
+u64 ACNHSarc::GetDecompressedSize() const {
+    if (this->stream != nullptr)
+        return stream->GetDecompressedSize();
+
+    return this->dataSize;
 }
@@ -21,15 +21,26 @@
  */
 
 #include "BCSV.hpp"
+#include "MemoryMap.hpp"
+#include "CRC32.hpp"
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
+#include <thread>
+
+BCSV::BCSV(const char* filePath, bool mapFile, bool parseRows, const BCSVSchema* schema) {
+    if (mapFile && MemoryMap::IsSupported()) {
+        this->data = MemoryMap::Map(filePath, this->dataSize);
+        if (this->data == nullptr) {
+            InValidate("Failed to map file");
+            return;
+        }
 
-struct BCSVColumn {
-    u32 hash;
-    u32 offset;
-};
+        autoUnmapMem = true;
+        this->Init(parseRows, schema);
+        return;
+    }
 
-BCSV::BCSV(const char* filePath) {
     FILE* file = fopen(filePath, "r");
     if (file == NULL) {
         InValidate("Failed to open file");
@@ -43,7 +54,7 @@ BCSV::BCSV(const char* filePath) {
     size_t res = fread(this->data, sizeof(u8), dataSize, file);
     if (res == dataSize) {
         autoManageMem = true;
-        this->Init();
+        this->Init(parseRows, schema);
     }
     else {
         InValidate("Failed to fully read file");
@@ -52,23 +63,77 @@ BCSV::BCSV(const char* filePath) {
     fclose(file);
 }
 
-BCSV::BCSV(u8* inBuffer, u64 bufSize, bool manageMem) : data(inBuffer), dataSize(bufSize), autoManageMem(manageMem) {
+BCSV::BCSV(u8* inBuffer, u64 bufSize, bool manageMem, bool parseRows, const BCSVSchema* schema) : data(inBuffer), dataSize(bufSize), autoManageMem(manageMem) {
     if (inBuffer == nullptr || bufSize < 0xC) {
         InValidate("Invalid file buffer");
         return;
     }
 
-    this->Init();
+    this->Init(parseRows, schema);
+}
+
+BCSV::BCSV(BCSV&& other) noexcept {
+    MoveFrom(other);
+}
+
+BCSV& BCSV::operator=(BCSV&& other) noexcept {
+    if (this != &other) {
+        FreeData();
+        MoveFrom(other);
+    }
+    return *this;
 }
 
 BCSV::~BCSV() {
+    FreeData();
+}
+
+void BCSV::FreeData() {
     if (autoManageMem) {
         delete[] this->data;
         autoManageMem = false;
     }
+
+    if (autoUnmapMem) {
+        MemoryMap::Unmap(this->data, this->dataSize);
+        autoUnmapMem = false;
+    }
+}
+
+void BCSV::MoveFrom(BCSV& other) { //Cells and strings point into data, which moves along with them
+    this->data = other.data;
+    this->dataSize = other.dataSize;
+    this->errorMessage = other.errorMessage;
+    this->autoManageMem = other.autoManageMem;
+    this->autoUnmapMem = other.autoUnmapMem;
+    this->isValid = other.isValid;
+    this->numRows = other.numRows;
+    this->rowSize = other.rowSize;
+    this->numColumns = other.numColumns;
+    this->version = other.version;
+    this->jpEnumFlag = other.jpEnumFlag;
+    this->startPos = other.startPos;
+    this->rowsStart = other.rowsStart;
+    this->isParsed = other.isParsed;
+    this->columns = std::move(other.columns);
+    this->columnChecks = std::move(other.columnChecks);
+    this->columnsByHash = std::move(other.columnsByHash);
+    this->u8Values = std::move(other.u8Values);
+    this->u16Values = std::move(other.u16Values);
+    this->u32Values = std::move(other.u32Values);
+    this->floatValues = std::move(other.floatValues);
+    this->stringValues = std::move(other.stringValues);
+
+    other.data = nullptr;
+    other.dataSize = 0;
+    other.autoManageMem = false;
+    other.autoUnmapMem = false;
+    other.isParsed = false;
+    other.numRows = 0;
+    other.InValidate("Moved from");
 }
 
-void BCSV::Init() {
+void BCSV::Init(bool parseRows, const BCSVSchema* schema) {
     this->numRows = ReadU32(data);
     this->rowSize = ReadU32(data+4);
     this->numColumns = ReadU16(data+8);
@@ -97,78 +162,255 @@ void BCSV::Init() {
         return;
     }
 
-    this->Parse();
+    if (this->ParseColumns(schema ? *schema : BCSVSchema::Default()) && parseRows) {
+        this->ParseRows();
+    }
 }
 
 bool BCSV::IsValid() const {
     return isValid;
 }
 
+bool BCSV::IsParsed() const {
+    return isParsed;
+}
+
 const char* BCSV::GetErrorMessage() const {
     return errorMessage;
 }
 
-void BCSV::Parse() {
+bool BCSV::ParseColumns(const BCSVSchema& schema) {
     if (!IsValid()) {
-        return;
+        return false;
     }
 
-    std::vector<BCSVColumn> cols(numColumns);
+    this->rowsStart = this->startPos + (static_cast<u32>(numColumns) * 8);
+    if (rowsStart + (static_cast<u64>(numRows) * rowSize) > dataSize) {
+        InValidate("Rows past end of file");
+        return false;
+    }
 
+    columns.resize(numColumns);
     u32 pos = this->startPos;
     for (u16 i = 0; i < numColumns; i++, pos+=8) {
-        cols[i].hash = ReadU32(data + pos);
-        cols[i].offset = ReadU32(data + pos + 4);
+        columns[i].hash = ReadU32(data + pos);
+        columns[i].offset = ReadU32(data + pos + 4);
     }
 
-    for (u32 i = 0; i < this->numRows; i++, pos += this->rowSize) {
-        BCSVRow rowValues;
+    //Cell size runs up to the next column, so the type is decided once per column
+    static const u32 TypeSizes[] = { sizeof(u8), sizeof(u16), sizeof(u32), sizeof(float), 1 };
+    for (u16 i = 0; i < numColumns; i++) {
+        BCSVColumn& column = columns[i];
+        u32 end = (i < numColumns-1) ? columns[i+1].offset : this->rowSize;
+        if (column.offset >= rowSize) {
+            InValidate("Invalid column offset");
+            return false;
+        }
 
-        for (u16 j = 0; j < this->numColumns; j++) {
-            u32 size = this->rowSize - cols[j].offset;
-            if (j < this->numColumns-1) {
-                size = cols[j+1].offset - cols[j].offset;
-            }
+        if (end > rowSize || end < column.offset) { //Columns out of order, treat the rest of the row as a string
+            end = this->rowSize;
+        }
+        column.size = end - column.offset;
+
+        switch (column.size) {
+            case sizeof(u8):
+                column.type = ColumnType::UInt8;
+                break;
+
+            case sizeof(u16):
+                column.type = ColumnType::UInt16;
+                break;
+
+            case sizeof(u32):
+                column.type = ColumnType::UInt32;
+                break;
 
-            BCSVField row; row.type = ColumnType::String;
-            if (size == sizeof(u8)) {
-                row.type = ColumnType::UInt8;
-                row.UInt8 = data[pos+cols[j].offset];
+            default:
+                column.type = ColumnType::String;
+                break;
+        }
+
+        ColumnType declaredType;
+        column.declared = schema.Find(column.hash, declaredType) && TypeSizes[static_cast<u8>(declaredType)] <= column.size;
+        if (column.declared) {
+            column.type = declaredType;
+        }
+        else if (column.type == ColumnType::UInt32) { //Might be Float, which takes a scan of the column (see CheckColumn)
+            if (columnChecks.empty()) {
+                columnChecks = std::vector<std::atomic<u8>>(numColumns);
             }
+            columnChecks[i].store(Check_Pending, std::memory_order_relaxed);
+        }
+    }
 
-            else if (size == sizeof(u16)) {
-                row.type = ColumnType::UInt16;
-                row.UInt16 = ReadU16(data + pos+cols[j].offset);
+    columnsByHash.resize(numColumns);
+    for (u16 i = 0; i < numColumns; i++) {
+        columnsByHash[i] = i;
+    }
+    std::stable_sort(columnsByHash.begin(), columnsByHash.end(),
+        [this](u16 a, u16 b) { return columns[a].hash < columns[b].hash; });
+    return true;
+}
+
+bool BCSV::IsFloatColumn(const BCSVColumn& column) const {
+    //Stops at the first cell that isn't a positive normal float, which small integers and hashes hit early
+    bool hasFloat = false;
+    const u8* cell = GetCell(0, column);
+    for (u32 row = 0; row < numRows; row++, cell += rowSize) {
+        u32 bits = ReadU32(cell);
+        if (bits == 0) //0 is both, so it doesn't decide
+            continue;
+
+        u32 exponent = (bits >> 23) & 0xFF;
+        if ((bits & 0x80000000) || exponent == 0 || exponent == 0xFF)
+            return false;
+        hasFloat = true;
+    }
+    return hasFloat;
+}
+
+const BCSVColumn* BCSV::CheckColumn(const BCSVColumn* column) const {
+    //Const lookups can race here, so one caller scans the column and any others wait for its result
+    if (column == nullptr || columnChecks.empty())
+        return column;
+
+    std::atomic<u8>& check = columnChecks[column - columns.data()];
+    u8 state = check.load(std::memory_order_acquire);
+    if (state == Check_Done)
+        return column;
+
+    if (state == Check_Pending && check.compare_exchange_strong(state, Check_Running, std::memory_order_acquire)) {
+        BCSVColumn& pending = columns[column - columns.data()];
+        if (IsFloatColumn(pending)) {
+            pending.type = ColumnType::Float;
+        }
+        check.store(Check_Done, std::memory_order_release);
+        return column;
+    }
+
+    while (check.load(std::memory_order_acquire) != Check_Done) {
+        std::this_thread::yield();
+    }
+    return column;
+}
+
+void BCSV::CheckColumns() const {
+    for (const BCSVColumn& column : columns) {
+        CheckColumn(&column);
+    }
+}
+
+void BCSV::ParseRows() {
+    CheckColumns(); //Types decide the pools, so nothing can stay pending
+    std::vector<std::atomic<u8>>().swap(columnChecks);
+
+    u32 typeCounts[5] = {};
+    for (BCSVColumn& column : columns) {
+        column.valueIndex = typeCounts[static_cast<u8>(column.type)]++ * numRows;
+    }
+
+    u8Values.resize(static_cast<u64>(typeCounts[static_cast<u8>(ColumnType::UInt8)]) * numRows);
+    u16Values.resize(static_cast<u64>(typeCounts[static_cast<u8>(ColumnType::UInt16)]) * numRows);
+    u32Values.resize(static_cast<u64>(typeCounts[static_cast<u8>(ColumnType::UInt32)]) * numRows);
+    floatValues.resize(static_cast<u64>(typeCounts[static_cast<u8>(ColumnType::Float)]) * numRows);
+    stringValues.resize(static_cast<u64>(typeCounts[static_cast<u8>(ColumnType::String)]) * numRows);
+
+    //Column at a time: a strided read of data into a contiguous array.
+    //Locals, as stores through u8 pointers could otherwise alias the members
+    const u32 rows = this->numRows;
+    const u32 stride = this->rowSize;
+    for (const BCSVColumn& column : columns) {
+        const u8* cell = GetCell(0, column);
+        switch (column.type) {
+            case ColumnType::UInt8: {
+                u8* out = u8Values.data() + column.valueIndex;
+                for (u32 row = 0; row < rows; row++, cell += stride)
+                    out[row] = *cell;
+                break;
             }
 
-            else if (size == sizeof(u32)) {
-                row.UInt32 = ReadU32(data + pos+cols[j].offset);
-                if (IsFloat(row.UInt32)) {
-                    row.type = ColumnType::Float;
-                    row.Float = ReadFloat(&row.UInt32); //properly convert the hex representation to float
-                }
+            case ColumnType::UInt16: {
+                u16* out = u16Values.data() + column.valueIndex;
+                for (u32 row = 0; row < rows; row++, cell += stride)
+                    out[row] = ReadU16(cell);
+                break;
+            }
 
-                else {
-                    row.type = ColumnType::UInt32;
-                }
+            case ColumnType::UInt32: {
+                u32* out = u32Values.data() + column.valueIndex;
+                for (u32 row = 0; row < rows; row++, cell += stride)
+                    out[row] = ReadU32(cell);
+                break;
             }
 
-            if (row.type == ColumnType::String) {
-                row.String = reinterpret_cast<const char*>(data + pos+cols[j].offset);
+            case ColumnType::Float: {
+                float* out = floatValues.data() + column.valueIndex;
+                for (u32 row = 0; row < rows; row++, cell += stride)
+                    out[row] = ReadFloat(cell);
+                break;
             }
 
-            rowValues[cols[j].hash] = row;
+            default: {
+                const char** out = stringValues.data() + column.valueIndex;
+                for (u32 row = 0; row < rows; row++, cell += stride)
+                    out[row] = reinterpret_cast<const char*>(cell);
+                break;
+            }
         }
-        this->csvData.push_back(std::move(rowValues));
     }
+    isParsed = true;
+}
+
+const BCSVColumn* BCSV::FindColumn(u32 columnHash) const {
+    auto it = std::lower_bound(columnsByHash.begin(), columnsByHash.end(), columnHash,
+        [this](u16 index, u32 hash) { return columns[index].hash < hash; });
+
+    if (it == columnsByHash.end() || columns[*it].hash != columnHash) {
+        return nullptr;
+    }
+    return &columns[*it];
+}
+
+BCSVField BCSV::GetField(const BCSVColumn& column, u32 row) const {
+    BCSVField field;
+    field.type = column.type;
+    const u8* cell = GetCell(row, column);
+    switch (column.type) {
+        case ColumnType::UInt8:
+            field.UInt8 = isParsed ? u8Values[column.valueIndex + row] : *cell;
+            break;
+
+        case ColumnType::UInt16:
+            field.UInt16 = isParsed ? u16Values[column.valueIndex + row] : ReadU16(cell);
+            break;
+
+        case ColumnType::UInt32:
+            field.UInt32 = isParsed ? u32Values[column.valueIndex + row] : ReadU32(cell);
+            break;
+
+        case ColumnType::Float:
+            field.Float = isParsed ? floatValues[column.valueIndex + row] : ReadFloat(cell);
+            break;
+
+        default:
+            field.String = reinterpret_cast<const char*>(cell);
+            break;
+    }
+    return field;
 }
 
 bool BCSV::GetAll(BCSVData& outData) const {
-    if (IsValid()) {
-        outData = this->csvData;
-        return true;
+    if (!IsValid())
+        return false;
+
+    CheckColumns();
+    outData.assign(numRows, BCSVRow());
+    for (u32 row = 0; row < numRows; row++) {
+        for (const BCSVColumn& column : columns) {
+            outData[row][column.hash] = GetField(column, row);
+        }
     }
-    return false;
+    return true;
 }
 
 bool BCSV::GetColumnByHash(std::vector<BCSVField>& outCols, u32 columnHash) const {
@@ -176,10 +418,14 @@ bool BCSV::GetColumnByHash(std::vector<BCSVField>& outCols, u32 columnHash) cons
         return false;
 
     outCols.clear();
-    for (const auto& i : this->csvData) {
-        if (i.find(columnHash) != i.end()) { //equivalent to C++20's 'contains'
-            outCols.push_back(i.at(columnHash));
-        }
+    const BCSVColumn* column = CheckColumn(FindColumn(columnHash));
+    if (column == nullptr) {
+        return true;
+    }
+
+    outCols.resize(numRows);
+    for (u32 row = 0; row < numRows; row++) {
+        outCols[row] = GetField(*column, row);
     }
     return true;
 }
@@ -193,13 +439,180 @@ u32 BCSV::GetColCount() const {
 }
 
 bool BCSV::GetRow(BCSVRow& outRow, u32 index) const {
-    if (!IsValid() || index > csvData.size())
+    if (!IsValid() || index >= numRows)
         return false;
 
-    outRow = csvData[index];
+    CheckColumns();
+    outRow.clear();
+    for (const BCSVColumn& column : columns) {
+        outRow[column.hash] = GetField(column, index);
+    }
+    return true;
+}
+
+BCSVRowView BCSV::GetRowView(u32 index) const {
+    if (!IsValid() || index >= numRows)
+        return BCSVRowView();
+
+    return BCSVRowView(this, index);
+}
+
+BCSVColumnView BCSV::GetColumnView(u32 columnHash) const {
+    const BCSVColumn* column = GetColumnInfo(columnHash);
+    if (column == nullptr)
+        return BCSVColumnView();
+
+    return BCSVColumnView(this, column);
+}
+
+const BCSVColumn* BCSV::GetColumnInfo(u32 columnHash) const {
+    return IsValid() ? CheckColumn(FindColumn(columnHash)) : nullptr;
+}
+
+const BCSVColumn* BCSV::GetColumnInfoByIndex(u16 index) const {
+    if (!IsValid() || index >= columns.size())
+        return nullptr;
+
+    return CheckColumn(&columns[index]);
+}
+
+bool BCSV::GetColumn(u32 columnHash, const u8*& outValues) const {
+    const BCSVColumn* column = GetColumnInfo(columnHash);
+    if (column == nullptr || column->type != ColumnType::UInt8 || !isParsed)
+        return false;
+
+    outValues = u8Values.data() + column->valueIndex;
+    return true;
+}
+
+bool BCSV::GetColumn(u32 columnHash, const u16*& outValues) const {
+    const BCSVColumn* column = GetColumnInfo(columnHash);
+    if (column == nullptr || column->type != ColumnType::UInt16 || !isParsed)
+        return false;
+
+    outValues = u16Values.data() + column->valueIndex;
     return true;
 }
 
+bool BCSV::GetColumn(u32 columnHash, const u32*& outValues) const {
+    const BCSVColumn* column = GetColumnInfo(columnHash);
+    if (column == nullptr || column->type != ColumnType::UInt32 || !isParsed)
+        return false;
+
+    outValues = u32Values.data() + column->valueIndex;
+    return true;
+}
+
+bool BCSV::GetColumn(u32 columnHash, const float*& outValues) const {
+    const BCSVColumn* column = GetColumnInfo(columnHash);
+    if (column == nullptr || column->type != ColumnType::Float || !isParsed)
+        return false;
+
+    outValues = floatValues.data() + column->valueIndex;
+    return true;
+}
+
+bool BCSV::GetColumn(u32 columnHash, const char* const*& outValues) const {
+    const BCSVColumn* column = GetColumnInfo(columnHash);
+    if (column == nullptr || column->type != ColumnType::String || !isParsed)
+        return false;
+
+    outValues = stringValues.data() + column->valueIndex;
+    return true;
+}
+
+void BCSVSchema::Register(u32 columnHash, ColumnType type) {
+    types[columnHash] = type;
+}
+
+void BCSVSchema::Register(const char* columnName, ColumnType type) {
+    Register(CRC32::Calc(columnName), type);
+}
+
+bool BCSVSchema::Unregister(u32 columnHash) {
+    return types.erase(columnHash) != 0;
+}
+
+void BCSVSchema::Clear() {
+    types.clear();
+}
+
+bool BCSVSchema::Find(u32 columnHash, ColumnType& outType) const {
+    auto it = types.find(columnHash);
+    if (it == types.end())
+        return false;
+
+    outType = it->second;
+    return true;
+}
+
+u32 BCSVSchema::GetSize() const {
+    return static_cast<u32>(types.size());
+}
+
+BCSVSchema& BCSVSchema::Default() {
+    static BCSVSchema schema;
+    return schema;
+}
+
+BCSVRowView::BCSVRowView(const BCSV* bcsv, u32 row) : bcsv(bcsv), row(row) {
+
+}
+
+bool BCSVRowView::IsValid() const {
+    return bcsv != nullptr && bcsv->IsValid();
+}
+
+u32 BCSVRowView::GetIndex() const {
+    return row;
+}
+
+bool BCSVRowView::GetField(u32 columnHash, BCSVField& outField) const {
+    const BCSVColumn* column = IsValid() ? bcsv->GetColumnInfo(columnHash) : nullptr;
+    if (column == nullptr)
+        return false;
+
+    outField = bcsv->GetField(*column, row);
+    return true;
+}
+
+bool BCSVRowView::GetFieldByIndex(u16 columnIndex, BCSVField& outField) const {
+    const BCSVColumn* column = IsValid() ? bcsv->GetColumnInfoByIndex(columnIndex) : nullptr;
+    if (column == nullptr)
+        return false;
+
+    outField = bcsv->GetField(*column, row);
+    return true;
+}
+
+BCSVColumnView::BCSVColumnView(const BCSV* bcsv, const BCSVColumn* column) : bcsv(bcsv), column(column) {
+
+}
+
+bool BCSVColumnView::IsValid() const {
+    return bcsv != nullptr && bcsv->IsValid();
+}
+
+u32 BCSVColumnView::GetSize() const {
+    return IsValid() ? bcsv->numRows : 0;
+}
+
+const BCSVColumn* BCSVColumnView::GetInfo() const {
+    return IsValid() ? column : nullptr;
+}
+
+BCSVField BCSVColumnView::operator[](u32 row) const {
+    return bcsv->GetField(*column, row);
+}
+
+BCSVColumnView::Iterator BCSVColumnView::begin() const {
+    return Iterator(this, 0);
+}
+
+BCSVColumnView::Iterator BCSVColumnView::end() const {
+    return Iterator(this, GetSize());
+}
+
 void BCSVField::Print() const {
 #ifdef DEBUG
     switch (type) {
@@ -231,17 +644,17 @@ void BCSVField::Print() const {
 
 void BCSV::Print() const {
 #ifdef DEBUG
-    for (const auto& slot : csvData[0]) {
-        printf("%08X ", slot.first);
+    CheckColumns();
+    for (const BCSVColumn& column : columns) {
+        printf("%08X ", column.hash);
     }
 
     printf("\n");
-    for (const auto& i : this->csvData) {
-        for (const auto& slot : i) {
-            slot.second.Print();
+    for (u32 row = 0; row < numRows; row++) {
+        for (const BCSVColumn& column : columns) {
+            GetField(column, row).Print();
         }
         printf("\n");
     }
 #endif
 }
-
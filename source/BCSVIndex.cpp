@@ -0,0 +1,442 @@
+/**
+ *
+ * BCSVIndex.cpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+
+#include "BCSVIndex.hpp"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <numeric>
+
+static const constexpr u32 CacheMagic = 0x58444942; //"BIDX"
+static const constexpr u32 CacheVersion = 1;
+static const constexpr u32 CacheHeaderSize = 0x18; //Magic, version, fingerprint, row count, index count
+
+static inline u32 MixHash(u32 hash) { //MurmurHash3 finalizer, so nearby keys land in different slots
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static inline u32 HashString(const char* str, u32 length) { //FNV-1a
+    u32 hash = 0x811C9DC5;
+    for (u32 i = 0; i < length; i++)
+        hash = (hash ^ static_cast<u8>(str[i])) * 0x01000193;
+    return MixHash(hash);
+}
+
+BCSVIndex::BCSVIndex(const BCSV& bcsv) : bcsv(bcsv) {
+    if (!bcsv.IsValid()) {
+        InValidate("Invalid BCSV");
+    }
+}
+
+bool BCSVIndex::IsValid() const {
+    return isValid && bcsv.IsValid();
+}
+
+const char* BCSVIndex::GetErrorMessage() const {
+    return errorMessage;
+}
+
+u32 BCSVIndex::ReadKey(const BCSVColumn& column, u32 row) const {
+    const u8* cell = bcsv.GetCell(row, column);
+    switch (column.type) {
+        case ColumnType::UInt8:
+            return *cell;
+
+        case ColumnType::UInt16:
+            return Endian::ReadU16<false>(cell);
+
+        default:
+            return Endian::ReadU32<false>(cell);
+    }
+}
+
+const char* BCSVIndex::ReadString(const BCSVColumn& column, u32 row, u32& outLength) const {
+    const char* cell = reinterpret_cast<const char*>(bcsv.GetCell(row, column));
+    outLength = static_cast<u32>(strnlen(cell, column.size)); //Full cells aren't null terminated
+    return cell;
+}
+
+void BCSVIndex::SortRows(ColumnIndex& index) const {
+    const BCSVColumn& column = *index.column;
+    u32 rowCount = bcsv.GetRowCount();
+    index.rows.resize(rowCount);
+    if (column.type == ColumnType::String) {
+        std::iota(index.rows.begin(), index.rows.end(), 0);
+        std::stable_sort(index.rows.begin(), index.rows.end(), [this, &column](u32 a, u32 b) {
+            return strncmp(reinterpret_cast<const char*>(bcsv.GetCell(a, column)),
+                reinterpret_cast<const char*>(bcsv.GetCell(b, column)), column.size) < 0;
+        });
+        return;
+    }
+
+    //Value in the high half and row in the low half, so one plain sort keeps equal values in row order
+    std::vector<u64> entries(rowCount);
+    for (u32 row = 0; row < rowCount; row++) {
+        entries[row] = (static_cast<u64>(ReadKey(column, row)) << 32) | row;
+    }
+    std::sort(entries.begin(), entries.end());
+
+    index.keys.resize(rowCount);
+    for (u32 i = 0; i < rowCount; i++) {
+        index.rows[i] = static_cast<u32>(entries[i]);
+        index.keys[i] = static_cast<u32>(entries[i] >> 32);
+    }
+}
+
+bool BCSVIndex::BuildGroups(ColumnIndex& index) const { //False if 'rows' isn't in order, e.g. a damaged cache
+    const BCSVColumn& column = *index.column;
+    u32 count = static_cast<u32>(index.rows.size());
+    index.groups.clear();
+    if (count != 0) {
+        index.groups.push_back(0);
+    }
+
+    for (u32 i = 1; i < count; i++) {
+        int order;
+        if (column.type == ColumnType::String) {
+            order = strncmp(reinterpret_cast<const char*>(bcsv.GetCell(index.rows[i-1], column)),
+                reinterpret_cast<const char*>(bcsv.GetCell(index.rows[i], column)), column.size);
+        }
+        else {
+            order = (index.keys[i-1] < index.keys[i]) ? -1 : (index.keys[i-1] > index.keys[i]);
+        }
+
+        if (order > 0 || (order == 0 && index.rows[i-1] >= index.rows[i]))
+            return false;
+
+        if (order != 0) {
+            index.groups.push_back(i);
+        }
+    }
+    index.groups.push_back(count);
+    return true;
+}
+
+void BCSVIndex::BuildSlots(ColumnIndex& index) const {
+    const BCSVColumn& column = *index.column;
+    u32 groupCount = static_cast<u32>(index.groups.size() - 1);
+    u64 slotCount = 2;
+    while (slotCount < static_cast<u64>(groupCount) * 2) { //At most half full
+        slotCount <<= 1;
+    }
+
+    index.slots.assign(slotCount, 0);
+    u32 mask = static_cast<u32>(slotCount - 1);
+    for (u32 group = 0; group < groupCount; group++) {
+        u32 first = index.groups[group];
+        u32 hash;
+        if (column.type == ColumnType::String) {
+            u32 length;
+            const char* str = ReadString(column, index.rows[first], length);
+            hash = HashString(str, length);
+        }
+        else {
+            hash = MixHash(index.keys[first]);
+        }
+
+        u32 pos = hash & mask;
+        while (index.slots[pos] != 0) {
+            pos = (pos + 1) & mask;
+        }
+        index.slots[pos] = group + 1;
+    }
+}
+
+u32 BCSVIndex::FindGroup(const ColumnIndex& index, u32 value) const {
+    u32 mask = static_cast<u32>(index.slots.size() - 1);
+    for (u32 pos = MixHash(value) & mask; index.slots[pos] != 0; pos = (pos + 1) & mask) {
+        u32 group = index.slots[pos] - 1;
+        if (index.keys[index.groups[group]] == value)
+            return group;
+    }
+    return static_cast<u32>(index.groups.size() - 1);
+}
+
+u32 BCSVIndex::FindGroup(const ColumnIndex& index, const char* value) const {
+    u32 missing = static_cast<u32>(index.groups.size() - 1);
+    size_t valueLength = strlen(value);
+    if (valueLength > index.column->size)
+        return missing;
+
+    u32 mask = static_cast<u32>(index.slots.size() - 1);
+    for (u32 pos = HashString(value, static_cast<u32>(valueLength)) & mask; index.slots[pos] != 0; pos = (pos + 1) & mask) {
+        u32 group = index.slots[pos] - 1;
+        u32 length;
+        const char* str = ReadString(*index.column, index.rows[index.groups[group]], length);
+        if (length == valueLength && memcmp(str, value, length) == 0)
+            return group;
+    }
+    return missing;
+}
+
+BCSVIndex::ColumnIndex* BCSVIndex::GetIndex(u32 columnHash) {
+    if (!IsValid()) {
+        Fail("Invalid BCSV");
+        return nullptr;
+    }
+
+    auto it = indexes.find(columnHash);
+    if (it != indexes.end())
+        return &it->second;
+
+    const BCSVColumn* column = bcsv.GetColumnInfo(columnHash);
+    if (column == nullptr) {
+        Fail("Column not found");
+        return nullptr;
+    }
+
+    if (column->type == ColumnType::Float) {
+        Fail("Float columns can't be indexed");
+        return nullptr;
+    }
+
+    ColumnIndex& index = indexes[columnHash];
+    index.column = column;
+    SortRows(index);
+    BuildGroups(index);
+    BuildSlots(index);
+    return &index;
+}
+
+bool BCSVIndex::Build(u32 columnHash) {
+    return GetIndex(columnHash) != nullptr;
+}
+
+bool BCSVIndex::IsBuilt(u32 columnHash) const {
+    return indexes.find(columnHash) != indexes.end();
+}
+
+bool BCSVIndex::FindRow(u32 columnHash, u32 value, u32& outRow) {
+    const u32* rows;
+    u32 count;
+    if (!EqualRange(columnHash, value, rows, count))
+        return false;
+
+    if (count == 0)
+        return Fail("No row with this value");
+
+    outRow = rows[0]; //Equal values are in row order
+    return true;
+}
+
+bool BCSVIndex::FindRow(u32 columnHash, const char* value, u32& outRow) {
+    const u32* rows;
+    u32 count;
+    if (!EqualRange(columnHash, value, rows, count))
+        return false;
+
+    if (count == 0)
+        return Fail("No row with this value");
+
+    outRow = rows[0];
+    return true;
+}
+
+bool BCSVIndex::EqualRange(u32 columnHash, u32 value, const u32*& outRows, u32& outCount) {
+    const ColumnIndex* index = GetIndex(columnHash);
+    if (index == nullptr)
+        return false;
+
+    if (index->column->type == ColumnType::String)
+        return Fail("String column, query it with a string");
+
+    u32 group = FindGroup(*index, value);
+    u32 first = index->groups[group];
+    outRows = index->rows.data() + first;
+    outCount = (group + 1 < index->groups.size()) ? index->groups[group + 1] - first : 0;
+    return true;
+}
+
+bool BCSVIndex::EqualRange(u32 columnHash, const char* value, const u32*& outRows, u32& outCount) {
+    if (value == nullptr)
+        return Fail("Invalid value");
+
+    const ColumnIndex* index = GetIndex(columnHash);
+    if (index == nullptr)
+        return false;
+
+    if (index->column->type != ColumnType::String)
+        return Fail("Numeric column, query it with a number");
+
+    u32 group = FindGroup(*index, value);
+    u32 first = index->groups[group];
+    outRows = index->rows.data() + first;
+    outCount = (group + 1 < index->groups.size()) ? index->groups[group + 1] - first : 0;
+    return true;
+}
+
+bool BCSVIndex::Range(u32 columnHash, u32 minValue, u32 maxValue, const u32*& outRows, u32& outCount) {
+    const ColumnIndex* index = GetIndex(columnHash);
+    if (index == nullptr)
+        return false;
+
+    if (index->column->type == ColumnType::String)
+        return Fail("Range queries need a numeric column");
+
+    auto first = std::lower_bound(index->keys.begin(), index->keys.end(), minValue);
+    auto last = (minValue <= maxValue) ? std::upper_bound(first, index->keys.end(), maxValue) : first;
+    outRows = index->rows.data() + (first - index->keys.begin());
+    outCount = static_cast<u32>(last - first);
+    return true;
+}
+
+u64 BCSVIndex::GetFingerprint() { //Not a checksum of any format, just enough to tell this table's cache from others
+    if (fingerprintBuilt)
+        return fingerprint;
+
+    const u8* data = bcsv.data;
+    u64 size = bcsv.dataSize;
+    u64 lanes[4] = { size, size + 1, size + 2, size + 3 }; //Independent, so the multiplies overlap
+    u64 pos = 0;
+    for (; pos + 32 <= size; pos += 32) {
+        for (u32 i = 0; i < 4; i++) {
+            lanes[i] = (lanes[i] ^ Endian::ReadU64<false>(data + pos + (i * 8))) * 0x9E3779B97F4A7C15;
+            lanes[i] ^= lanes[i] >> 32;
+        }
+    }
+
+    u64 hash = lanes[0];
+    for (u32 i = 1; i < 4; i++) {
+        hash = ((hash ^ lanes[i]) * 0x9E3779B97F4A7C15) ^ (hash >> 32);
+    }
+
+    for (; pos + 8 <= size; pos += 8) {
+        hash = (hash ^ Endian::ReadU64<false>(data + pos)) * 0x9E3779B97F4A7C15;
+        hash ^= hash >> 32;
+    }
+
+    u64 tail = 0;
+    for (u32 i = 0; pos + i < size; i++) {
+        tail |= static_cast<u64>(data[pos + i]) << (i * 8);
+    }
+    hash = (hash ^ tail) * 0x9E3779B97F4A7C15;
+
+    this->fingerprint = hash ^ (hash >> 29);
+    this->fingerprintBuilt = true;
+    return fingerprint;
+}
+
+bool BCSVIndex::Save(const char* filePath) {
+    if (!IsValid() || filePath == nullptr)
+        return Fail("Invalid BCSV or file path");
+
+    u32 rowCount = bcsv.GetRowCount();
+    std::vector<u8> out(CacheHeaderSize + (indexes.size() * (4 + (static_cast<u64>(rowCount) * 4))));
+    Endian::WriteU32<false>(out.data(), CacheMagic);
+    Endian::WriteU32<false>(out.data() + 4, CacheVersion);
+    Endian::WriteU64<false>(out.data() + 8, GetFingerprint());
+    Endian::WriteU32<false>(out.data() + 0x10, rowCount);
+    Endian::WriteU32<false>(out.data() + 0x14, static_cast<u32>(indexes.size()));
+
+    u8* pos = out.data() + CacheHeaderSize;
+    for (const auto& entry : indexes) {
+        Endian::WriteU32<false>(pos, entry.first);
+        pos += 4;
+        for (u32 row : entry.second.rows) {
+            Endian::WriteU32<false>(pos, row);
+            pos += 4;
+        }
+    }
+
+    FILE* file = fopen(filePath, "wb");
+    if (file == NULL)
+        return Fail("Failed to open file");
+
+    bool res = fwrite(out.data(), sizeof(u8), out.size(), file) == out.size();
+    if (fclose(file) != 0)
+        res = false;
+    return res ? true : Fail("Failed to write file");
+}
+
+bool BCSVIndex::Load(const char* filePath) {
+    if (!IsValid() || filePath == nullptr)
+        return Fail("Invalid BCSV or file path");
+
+    FILE* file = fopen(filePath, "rb");
+    if (file == NULL)
+        return Fail("Failed to open file");
+
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    rewind(file);
+    std::vector<u8> in(fileSize > 0 ? static_cast<u64>(fileSize) : 0);
+    bool res = fread(in.data(), sizeof(u8), in.size(), file) == in.size();
+    fclose(file);
+    if (!res || in.size() < CacheHeaderSize)
+        return Fail("Failed to read file");
+
+    u32 rowCount = bcsv.GetRowCount();
+    if (Endian::ReadU32<false>(in.data()) != CacheMagic || Endian::ReadU32<false>(in.data() + 4) != CacheVersion)
+        return Fail("Invalid index cache");
+
+    if (Endian::ReadU64<false>(in.data() + 8) != GetFingerprint() || Endian::ReadU32<false>(in.data() + 0x10) != rowCount)
+        return Fail("Index cache is for other table data");
+
+    u32 indexCount = Endian::ReadU32<false>(in.data() + 0x14);
+    if (in.size() != CacheHeaderSize + (indexCount * (4 + (static_cast<u64>(rowCount) * 4))))
+        return Fail("Invalid index cache");
+
+    //Built aside, so a bad cache leaves the current indexes alone
+    std::vector<std::pair<u32, ColumnIndex>> loaded(indexCount);
+    std::vector<bool> seen(rowCount);
+    const u8* pos = in.data() + CacheHeaderSize;
+    for (auto& entry : loaded) {
+        entry.first = Endian::ReadU32<false>(pos);
+        pos += 4;
+
+        ColumnIndex& index = entry.second;
+        index.column = bcsv.GetColumnInfo(entry.first);
+        if (index.column == nullptr || index.column->type == ColumnType::Float)
+            return Fail("Invalid index cache");
+
+        bool numeric = index.column->type != ColumnType::String;
+        index.rows.resize(rowCount);
+        index.keys.resize(numeric ? rowCount : 0);
+        std::fill(seen.begin(), seen.end(), false);
+        for (u32 i = 0; i < rowCount; i++, pos += 4) {
+            u32 row = Endian::ReadU32<false>(pos);
+            if (row >= rowCount || seen[row])
+                return Fail("Invalid index cache");
+
+            seen[row] = true;
+            index.rows[i] = row;
+            if (numeric) {
+                index.keys[i] = ReadKey(*index.column, row);
+            }
+        }
+
+        if (!BuildGroups(index))
+            return Fail("Invalid index cache");
+        BuildSlots(index);
+    }
+
+    for (auto& entry : loaded) {
+        indexes[entry.first] = std::move(entry.second);
+    }
+    return true;
+}
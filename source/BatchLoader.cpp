@@ -0,0 +1,284 @@
+/**
+ *
+ * BatchLoader.cpp
+ *
+ * Copyright (c) 2021-2025, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#include "BatchLoader.hpp"
+#include "ACNHSarc.hpp"
+#include "zstd.h"
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+static const constexpr u32 MagicReadSize = 0x20;
+
+struct BatchQueue {
+    std::mutex lock;
+    std::deque<size_t> items;
+};
+
+//Limits how many bytes are being decoded at once; oversized files wait until nothing else is in flight
+class BatchBudget {
+private:
+    std::mutex lock;
+    std::condition_variable cond;
+    u64 used = 0;
+    u64 max;
+
+public:
+    BatchBudget(u64 maxBytes) : max(maxBytes ? maxBytes : 1) {}
+
+    u64 Acquire(u64 size) {
+        if (size > max)
+            size = max;
+
+        std::unique_lock<std::mutex> guard(lock);
+        cond.wait(guard, [&]() { return used + size <= max; });
+        used += size;
+        return size;
+    }
+
+    void Release(u64 size) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            used -= size;
+        }
+        cond.notify_all();
+    }
+};
+
+static bool PopWork(std::vector<BatchQueue>& queues, u32 worker, size_t& outIndex) {
+    { //Own queue first, newest item
+        BatchQueue& own = queues[worker];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.items.empty()) {
+            outIndex = own.items.back();
+            own.items.pop_back();
+            return true;
+        }
+    }
+
+    //Steal the oldest item from another worker
+    for (u32 i = 1; i < queues.size(); i++) {
+        BatchQueue& other = queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(other.lock);
+        if (!other.items.empty()) {
+            outIndex = other.items.front();
+            other.items.pop_front();
+            return true;
+        }
+    }
+    return false; //Nothing is ever queued after starting, so all work is done
+}
+
+BatchLoader::BatchLoader(u32 threadCount, u64 maxBytesInFlight, bool mapFiles) : threadCount(threadCount), maxBytesInFlight(maxBytesInFlight), mapFiles(mapFiles) {
+    if (this->threadCount == 0) {
+        this->threadCount = std::thread::hardware_concurrency();
+        if (this->threadCount == 0)
+            this->threadCount = 1;
+    }
+}
+
+u32 BatchLoader::GetThreadCount() const {
+    return threadCount;
+}
+
+BatchFileType BatchLoader::DetectType(const char* filePath, u64& outFileSize, u64& outDecodedSize) {
+    outFileSize = outDecodedSize = 0;
+    FILE* file = fopen(filePath, "rb");
+    if (file == NULL) {
+        return BatchFileType::Unknown;
+    }
+
+    fseek(file, 0, SEEK_END);
+    outFileSize = ftell(file);
+    rewind(file);
+
+    u8 magic[MagicReadSize] = {0};
+    size_t res = fread(magic, sizeof(u8), MagicReadSize, file);
+    fclose(file);
+
+    outDecodedSize = outFileSize;
+    if (res >= 4 && memcmp(magic, "SARC", 4) == 0) {
+        return BatchFileType::SARC;
+    }
+
+    if (res >= 8 && memcmp(magic, "MsgStdBn", 8) == 0) {
+        return BatchFileType::MSBT;
+    }
+
+    if (res >= 2 && (memcmp(magic, "YB", 2) == 0 || memcmp(magic, "BY", 2) == 0)) {
+        return BatchFileType::Byaml;
+    }
+
+    if (res >= 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD) { //zstd frame
+        u64 contentSize = ZSTD_getFrameContentSize(magic, res);
+        if (contentSize != ZSTD_CONTENTSIZE_ERROR && contentSize != ZSTD_CONTENTSIZE_UNKNOWN) {
+            outDecodedSize = contentSize;
+        }
+        else {
+            outDecodedSize = outFileSize * 4; //Rough guess, only used for the in-flight budget
+        }
+        return BatchFileType::ACNHSarc;
+    }
+
+    if (res >= 0x10 && memcmp(magic + 0xC, "VSCB", 4) == 0) { //BCSV v1
+        return BatchFileType::BCSV;
+    }
+
+    size_t pathLen = strlen(filePath);
+    if (pathLen >= 5 && strcmp(filePath + pathLen - 5, ".bcsv") == 0) { //BCSV v0 has no magic
+        return BatchFileType::BCSV;
+    }
+    return BatchFileType::Unknown;
+}
+
+void BatchLoader::Decode(BatchResult& result, bool mapFiles) {
+    const char* path = result.path.c_str();
+    switch (result.type) {
+        case BatchFileType::SARC:
+            result.sarc.reset(new SARC(path, mapFiles));
+            result.isValid = result.sarc->IsValid();
+            result.errorMessage = result.sarc->GetErrorMessage();
+            break;
+
+        case BatchFileType::ACNHSarc:
+            result.sarc.reset(new ACNHSarc(path));
+            result.isValid = result.sarc->IsValid();
+            result.errorMessage = result.sarc->GetErrorMessage();
+            break;
+
+        case BatchFileType::Byaml:
+            result.byaml.reset(new Byaml(path, mapFiles));
+            result.isValid = result.byaml->IsValid();
+            result.errorMessage = result.byaml->GetErrorMessage();
+            break;
+
+        case BatchFileType::BCSV:
+            result.bcsv.reset(new BCSV(path, mapFiles));
+            result.isValid = result.bcsv->IsValid();
+            result.errorMessage = result.bcsv->GetErrorMessage();
+            break;
+
+        case BatchFileType::MSBT:
+            result.msbt.reset(new MSBT(path, mapFiles));
+            result.isValid = result.msbt->IsValid();
+            result.errorMessage = result.msbt->GetErrorMessage();
+            break;
+
+        default:
+            result.isValid = false;
+            result.errorMessage = "Unknown file type";
+            break;
+    }
+}
+
+bool BatchLoader::LoadFile(BatchResult& result, bool mapFiles) {
+    auto start = std::chrono::steady_clock::now();
+
+    u64 decodedSize = 0;
+    result.type = DetectType(result.path.c_str(), result.fileSize, decodedSize);
+    Decode(result, mapFiles);
+
+    result.elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return result.isValid;
+}
+
+bool BatchLoader::Run(const std::vector<std::string>& paths, const std::function<void(size_t, BatchResult&)>& onResult) const {
+    if (paths.empty())
+        return true;
+
+    u32 workerCount = threadCount;
+    if (workerCount > paths.size())
+        workerCount = static_cast<u32>(paths.size());
+
+    std::vector<BatchQueue> queues(workerCount);
+    for (size_t i = 0; i < paths.size(); i++) {
+        queues[i % workerCount].items.push_back(i);
+    }
+
+    BatchBudget budget(maxBytesInFlight);
+    bool allValid = true;
+    std::mutex validLock;
+
+    auto worker = [&](u32 id) {
+        size_t index;
+        bool workerValid = true;
+        while (PopWork(queues, id, index)) {
+            auto start = std::chrono::steady_clock::now();
+
+            BatchResult result;
+            result.path = paths[index];
+
+            u64 decodedSize = 0;
+            result.type = DetectType(result.path.c_str(), result.fileSize, decodedSize);
+            auto waitStart = std::chrono::steady_clock::now();
+            u64 reserved = budget.Acquire(decodedSize);
+            auto waitEnd = std::chrono::steady_clock::now();
+            Decode(result, mapFiles);
+
+            auto waited = waitEnd - waitStart; //Kept out of elapsedNs, so it matches LoadFile
+            result.waitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count();
+            result.elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start - waited).count();
+            workerValid &= result.isValid;
+            onResult(index, result);
+            result = BatchResult(); //Free anything the callback didn't take before giving the budget back
+            budget.Release(reserved);
+        }
+
+        std::lock_guard<std::mutex> guard(validLock);
+        allValid &= workerValid;
+    };
+
+    std::vector<std::thread> threads;
+    for (u32 i = 1; i < workerCount; i++) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0); //Calling thread works too
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return allValid;
+}
+
+bool BatchLoader::Load(const std::vector<std::string>& paths, std::vector<BatchResult>& outResults) const {
+    outResults.clear();
+    outResults.resize(paths.size());
+
+    //Each index is only ever written by one worker, no locking needed
+    //Results are kept, so the budget only bounds memory used while decoding
+    return Run(paths, [&](size_t index, BatchResult& result) {
+        outResults[index] = std::move(result);
+    });
+}
+
+bool BatchLoader::Load(const std::vector<std::string>& paths, const std::function<void(BatchResult&)>& callback) const {
+    std::mutex callbackLock;
+    return Run(paths, [&](size_t index, BatchResult& result) {
+        (void)index;
+        std::lock_guard<std::mutex> guard(callbackLock);
+        callback(result);
+    });
+}
@@ -21,10 +21,74 @@
  */
 
 #include "Byaml.hpp"
+#include "ByamlYaml.hpp"
+#include "MemoryMap.hpp"
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
+
+static const constexpr u32 MaxContainerDepth = 0x100; //Guards against offset cycles
+
+ByamlArena::~ByamlArena() {
+    Clear();
+}
+
+void ByamlArena::Reserve(u64 nodeCount, u64 entryCount) {
+    Clear();
+    this->nodes = nodeCount ? new ByamlNode[nodeCount] : nullptr;
+    this->entries = entryCount ? new ByamlHashEntry[entryCount] : nullptr;
+    this->nodeCount = nodeCount;
+    this->entryCount = entryCount;
+}
+
+void ByamlArena::Clear() {
+    delete[] this->nodes;
+    delete[] this->entries;
+    this->nodes = nullptr;
+    this->entries = nullptr;
+    this->nodeCount = this->nodePos = 0;
+    this->entryCount = this->entryPos = 0;
+}
+
+ByamlNode* ByamlArena::AllocNodes(u64 count) {
+    if (count > nodeCount - nodePos)
+        return nullptr;
+
+    ByamlNode* res = nodes + nodePos;
+    nodePos += count;
+    return res;
+}
+
+ByamlHashEntry* ByamlArena::AllocEntries(u64 count) {
+    if (count > entryCount - entryPos)
+        return nullptr;
+
+    ByamlHashEntry* res = entries + entryPos;
+    entryPos += count;
+    return res;
+}
+
+u64 ByamlArena::GetNodeCount() const {
+    return nodeCount;
+}
+
+u64 ByamlArena::GetEntryCount() const {
+    return entryCount;
+}
+
+Byaml::Byaml(const char* filePath, bool mapFile, bool parseTree) {
+    if (mapFile && MemoryMap::IsSupported()) {
+        this->data = MemoryMap::Map(filePath, this->dataSize);
+        if (this->data == nullptr) {
+            InValidate("Failed to map file");
+            return;
+        }
+
+        autoUnmapMem = true;
+        this->Init(parseTree);
+        return;
+    }
 
-Byaml::Byaml(const char* filePath) {
     FILE* file = fopen(filePath, "r");
     if (file == NULL) {
         InValidate("Failed to open file");
@@ -38,7 +102,7 @@ Byaml::Byaml(const char* filePath) {
     size_t res = fread(this->data, sizeof(u8), dataSize, file);
     if (res == dataSize) {
         autoManageMem = true;
-        this->Init();
+        this->Init(parseTree);
     } 
     else {
         InValidate("Failed to fully read file");
@@ -47,13 +111,13 @@ Byaml::Byaml(const char* filePath) {
     fclose(file);
 }
 
-Byaml::Byaml(u8* inBuffer, u64 bufSize, bool manageMem) : data(inBuffer), dataSize(bufSize), autoManageMem(manageMem) {
+Byaml::Byaml(u8* inBuffer, u64 bufSize, bool manageMem, bool parseTree) : data(inBuffer), dataSize(bufSize), autoManageMem(manageMem) {
     if (inBuffer == nullptr || bufSize < 0x10) {
         InValidate("Invalid file buffer");
         return;
     }
 
-    this->Init();
+    this->Init(parseTree);
 }
 
 Byaml::~Byaml() {
@@ -61,17 +125,26 @@ Byaml::~Byaml() {
         delete[] this->data;
         autoManageMem = false;
     }
+
+    if (autoUnmapMem) {
+        MemoryMap::Unmap(this->data, this->dataSize);
+        autoUnmapMem = false;
+    }
 }
 
-void Byaml::Init() {
+void Byaml::Init(bool parseTree) {
+    parentNode = ParseNullNode();
+    if (dataSize < 0x10) {
+        InValidate("Invalid file buffer");
+        return;
+    }
+
     if (data[0] == 'Y' && data[1] == 'B') { //Little Endian
         bigEndian = false;
     }
 
     else if (data[0] == 'B' && data[1] == 'Y') { //Big Endian
         bigEndian = true;
-        InValidate("Big Endian Unsupported"); //TODO: Technically supported but not tested
-        return;
     }
 
     else {
@@ -85,7 +158,16 @@ void Byaml::Init() {
         return;
     }
 
-    if (!this->Parse()) {
+    this->hashKeyTableOffset = ReadU32(data+0x4);
+    this->stringTableOffset = ReadU32(data+0x8);
+    this->rootOffset = ReadU32(data+0xC);
+    if (rootOffset > dataSize - 4 || hashKeyTableOffset > dataSize - 4 || stringTableOffset > dataSize - 4 ||
+        !IsTypeContainer((NodeType)ReadU8(data+rootOffset))) {
+        InValidate("Failed to Parse");
+        return;
+    }
+
+    if (parseTree && !(bigEndian ? this->Parse<true>() : this->Parse<false>())) {
         InValidate("Failed to Parse");
     }
 }
@@ -94,23 +176,130 @@ bool Byaml::IsValid() const {
     return isValid;
 }
 
+bool Byaml::IsParsed() const {
+    return isParsed;
+}
+
+bool Byaml::IsBigEndian() const {
+    return bigEndian;
+}
+
+ByamlView Byaml::GetRoot() const {
+    if (!IsValid())
+        return ByamlView();
+
+    return ByamlView(this, (NodeType)ReadU8(data+rootOffset), 0xC);
+}
+
+bool Byaml::FindTableIndex(u32 tableOffset, const char* str, u32& outIndex) const {
+    if (!IsValid() || str == nullptr || tableOffset == 0)
+        return false;
+
+    u32 low = 0, high = ReadU24(data+tableOffset+1);
+    while (low < high) {
+        u32 mid = low + ((high - low) / 2);
+        const char* midStr = ReadTableString(tableOffset, mid);
+        if (midStr == nullptr)
+            return false;
+
+        int res = strcmp(midStr, str);
+        if (res == 0) {
+            outIndex = mid;
+            return true;
+        }
+
+        if (res < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return false;
+}
+
+bool Byaml::GetKeyIndex(const char* key, u32& outIndex) const {
+    return FindTableIndex(hashKeyTableOffset, key, outIndex);
+}
+
+bool Byaml::GetStringIndex(const char* str, u32& outIndex) const {
+    return FindTableIndex(stringTableOffset, str, outIndex);
+}
+
+const ByamlNode* Byaml::Get(const ByamlNode& hashNode, const char* key) const {
+    u32 keyIndex = 0;
+    if (hashNode.type != NodeType::Hash || !GetKeyIndex(key, keyIndex))
+        return nullptr;
+
+    return hashNode.GetByKeyIndex(keyIndex);
+}
+
+const ByamlNode& Byaml::GetRootNode() const {
+    return parentNode;
+}
+
+const char* Byaml::ReadTableString(u32 tableOffset, u32 index) const {
+    if (tableOffset == 0 || index >= ReadU24(data+tableOffset+1))
+        return nullptr;
+
+    u64 entryOffset = tableOffset + 4 + (static_cast<u64>(index) * 4);
+    if (entryOffset + 4 > dataSize)
+        return nullptr;
+
+    u64 stringOffset = tableOffset + static_cast<u64>(ReadU32(data+entryOffset));
+    if (stringOffset >= dataSize)
+        return nullptr;
+    return reinterpret_cast<const char*>(data+stringOffset);
+}
+
 const char* Byaml::GetErrorMessage() const {
     return errorMessage;
 }
 
 bool Byaml::ToYaml(const char* filePath) const {
-    (void)(filePath);
+    FILE* file = (filePath != nullptr) ? fopen(filePath, "wb") : NULL;
+    if (file == NULL)
+        return false;
+
+    bool res = ToYaml(file);
+    if (fclose(file) != 0)
+        res = false;
+    return res;
+}
+
+bool Byaml::ToYaml(FILE* file) const {
+    return ToYaml(ByamlYamlEmitter::FileSink(file));
+}
+
+bool Byaml::ToYaml(int fd) const {
+    return ToYaml(ByamlYamlEmitter::FdSink(fd));
+}
+
+bool Byaml::ToYaml(const std::function<bool(const char* data, u64 size)>& sink) const {
     if (!IsValid())
         return false;
 
-    return true;
+    ByamlYamlEmitter emitter(sink);
+    return emitter.Emit(GetRoot());
 }
 
-Byaml* Byaml::FromYaml(const char* filePath) {
-    (void)(filePath);
-    return nullptr;
+Byaml* Byaml::FromYaml(const char* filePath, u16 version) {
+    ByamlYamlParser parser(version);
+    if (!parser.ParseFile(filePath))
+        return nullptr;
+
+    u64 size = 0;
+    u8* data = parser.GetWriter().Write(size);
+    if (data == nullptr)
+        return nullptr;
+
+    Byaml* byaml = new Byaml(data, size, true);
+    if (!byaml->IsValid()) {
+        delete byaml;
+        return nullptr;
+    }
+    return byaml;
 }
 
+template<bool BigEndian>
 bool Byaml::ParseTable(u32 offset, std::vector<const char*>& table) {
     NodeType node = (NodeType)data[offset];
     if (!IsTypeStringTable(node)) {
@@ -118,74 +307,152 @@ bool Byaml::ParseTable(u32 offset, std::vector<const char*>& table) {
     }
     
     table.clear();
-    u32 size = ReadU24(data+(offset+1));
+    u32 size = Endian::ReadU24<BigEndian>(data+(offset+1));
 
     for (u32 i = 0; i < size; i++) {
-        u32 stringOffset = offset + ReadU32(data+(offset+4+(i*4)));
+        u32 stringOffset = offset + Endian::ReadU32<BigEndian>(data+(offset+4+(i*4)));
         const char* strFromTable = reinterpret_cast<const char*>(data+stringOffset);
         table.push_back(strFromTable);
     }
     return true;
 }
 
+template<bool BigEndian>
 bool Byaml::Parse() {
-    u32 dataoffset = ReadU32(data+0xC);
-    NodeType node = (NodeType)ReadU8(data+dataoffset);
+    NodeType node = (NodeType)ReadU8(data+rootOffset);
     if (!IsTypeContainer(node)) {
         return false;
     }
 
-    u32 hashKeyTableOffset = ReadU32(data+0x4);
     if (hashKeyTableOffset != 0) {
-        ParseTable(hashKeyTableOffset, this->hashTable);
+        ParseTable<BigEndian>(hashKeyTableOffset, this->hashTable);
     }
 
-    u32 stringTableOffset = ReadU32(data+0x8);
     if (stringTableOffset != 0) {
-        ParseTable(stringTableOffset, this->stringTable);
+        ParseTable<BigEndian>(stringTableOffset, this->stringTable);
+    }
+
+    //Size the arena from the container headers first, so parsing never allocates
+    u64 nodeCount = 0, entryCount = 0;
+    u32 height = 0;
+    containerFlags.assign(dataSize / 4, 0);
+    bool res = CountContainer<BigEndian>(node, rootOffset, 0, nodeCount, entryCount, height);
+    if (res) {
+        arena.Reserve(nodeCount, entryCount);
+        parentNode = ParseNode<BigEndian>(node, 0xC);
+        res = parentNode.type != NodeType::Null;
     }
 
-    parentNode = ParseNode(node, 0xC);
-    if (parentNode.type == NodeType::Null) {
+    std::vector<u16>().swap(containerFlags);
+    sharedNodes.clear();
+    if (!res) {
         return false;
     }
+
+    isParsed = true;
     return true;
 }
 
+template<bool BigEndian>
+bool Byaml::CountContainer(NodeType node, u32 offset, u32 depth, u64& nodeCount, u64& entryCount, u32& outHeight) {
+    if (depth > MaxContainerDepth || (offset % 4) != 0 || static_cast<u64>(offset) + 4 > dataSize) {
+        return false;
+    }
+
+    u32 seenHeight = containerFlags[offset / 4] & ~Container_Shared;
+    if (seenHeight != 0) { //Already counted, only its depth from here needs checking
+        if (seenHeight == Container_Counting)
+            return false;
+
+        containerFlags[offset / 4] |= Container_Shared;
+        outHeight = seenHeight;
+        return depth + seenHeight - 1 <= MaxContainerDepth;
+    }
+    containerFlags[offset / 4] = Container_Counting;
+
+    u32 height = 0;
+    u32 size = Endian::ReadU24<BigEndian>(data+offset+1);
+    if (IsTypeArray(node)) {
+        u32 entryOffset = offset + 4 + (((size + 3) / 4) * 4);
+        if (entryOffset + (static_cast<u64>(size) * 4) > dataSize) {
+            return false;
+        }
+
+        nodeCount += size;
+        for (u32 i = 0; i < size; i++) {
+            NodeType childType = (NodeType)data[offset+4+i];
+            u32 childHeight = 0;
+            if (IsTypeContainer(childType) &&
+                !CountContainer<BigEndian>(childType, Endian::ReadU32<BigEndian>(data+entryOffset+(4*i)), depth+1, nodeCount, entryCount, childHeight)) {
+                return false;
+            }
+            height = std::max(height, childHeight);
+        }
+
+        outHeight = height + 1;
+        containerFlags[offset / 4] = static_cast<u16>(outHeight);
+        return true;
+    }
+
+    if (IsTypeHash(node)) {
+        if (offset + 4 + (static_cast<u64>(size) * 8) > dataSize) {
+            return false;
+        }
+
+        entryCount += size;
+        for (u32 i = 0; i < size; i++) {
+            u32 entryOffset = offset + 4 + (i*8);
+            NodeType childType = (NodeType)data[entryOffset+3];
+            u32 childHeight = 0;
+            if (IsTypeContainer(childType) &&
+                !CountContainer<BigEndian>(childType, Endian::ReadU32<BigEndian>(data+entryOffset+4), depth+1, nodeCount, entryCount, childHeight)) {
+                return false;
+            }
+            height = std::max(height, childHeight);
+        }
+
+        outHeight = height + 1;
+        containerFlags[offset / 4] = static_cast<u16>(outHeight);
+        return true;
+    }
+    return false;
+}
+
+template<bool BigEndian>
 ByamlNode Byaml::ParseNode(NodeType node, u32 offset) {
     switch (node) {
         case NodeType::String:
-            return ParseStringNode(offset);
+            return ParseStringNode<BigEndian>(offset);
 
         case NodeType::Binary:
-            return ParseBinaryNode(ReadU32(data+offset));
+            return ParseBinaryNode<BigEndian>(Endian::ReadU32<BigEndian>(data+offset));
 
         case NodeType::Array:
-            return ParseArrayNode(ReadU32(data+offset));
+            return ParseArrayNode<BigEndian>(Endian::ReadU32<BigEndian>(data+offset));
 
         case NodeType::Hash:
-            return ParseHashNode(ReadU32(data+offset));
+            return ParseHashNode<BigEndian>(Endian::ReadU32<BigEndian>(data+offset));
 
         case NodeType::Bool:
-            return ParseBoolNode(offset);
+            return ParseBoolNode<BigEndian>(offset);
 
         case NodeType::Int:
-            return ParseIntNode(offset);
+            return ParseIntNode<BigEndian>(offset);
 
         case NodeType::Float:
-            return ParseFloatNode(offset);
+            return ParseFloatNode<BigEndian>(offset);
 
         case NodeType::UInt:
-            return ParseUIntNode(offset);
+            return ParseUIntNode<BigEndian>(offset);
 
         case NodeType::Int64:
-            return ParseInt64Node(ReadU32(data+offset));
+            return ParseInt64Node<BigEndian>(Endian::ReadU32<BigEndian>(data+offset));
 
         case NodeType::UInt64:
-            return ParseUInt64Node(ReadU32(data+offset));
+            return ParseUInt64Node<BigEndian>(Endian::ReadU32<BigEndian>(data+offset));
 
         case NodeType::Double:
-            return ParseDoubleNode(ReadU32(data+offset));
+            return ParseDoubleNode<BigEndian>(Endian::ReadU32<BigEndian>(data+offset));
 
         case NodeType::Null:
             return ParseNullNode();
@@ -195,98 +462,133 @@ ByamlNode Byaml::ParseNode(NodeType node, u32 offset) {
     }
 }
 
+template<bool BigEndian>
 ByamlNode Byaml::ParseStringNode(u32 offset) {
     ByamlNode node;
     node.type = NodeType::String;
-    node.string = stringTable[ReadU32(data+offset)];
+    node.string = stringTable[Endian::ReadU32<BigEndian>(data+offset)];
     node.size = strlen(node.string);
     return node;
 }
 
+template<bool BigEndian>
 ByamlNode Byaml::ParseBinaryNode(u32 offset) {
     ByamlNode node;
     node.type = NodeType::Binary;
-    node.size = ReadU32(data+offset);
+    node.size = Endian::ReadU32<BigEndian>(data+offset);
     node.bytes = this->data+offset+4;
     return node;
 }
 
+template<bool BigEndian>
 ByamlNode Byaml::ParseArrayNode(u32 offset) {
+    bool shared = containerFlags[offset / 4] & Container_Shared;
+    if (shared) { //Every reference points at the same nodes
+        auto it = sharedNodes.find(offset);
+        if (it != sharedNodes.end())
+            return it->second;
+    }
+
     ByamlNode node;
     node.type = NodeType::Array;
-    node.array = new std::vector<ByamlNode>();
-    node.size = ReadU24(data+offset +1 );
+    node.size = Endian::ReadU24<BigEndian>(data+offset +1 );
+    node.array = arena.AllocNodes(node.size);
     u32 entryOffset = offset + AlignUp((s32)node.size, 4) + 4;
     for (u64 i = 0; i < node.size; i++) {
         u8 nodeType = data[offset+4+i];
-        node.array->push_back(ParseNode((NodeType)nodeType, entryOffset + (4*i)));
+        node.array[i] = ParseNode<BigEndian>((NodeType)nodeType, entryOffset + (4*i));
+    }
+
+    if (shared) {
+        sharedNodes[offset] = node;
     }
     return node;
 }
 
+template<bool BigEndian>
 ByamlNode Byaml::ParseHashNode(u32 offset) {
+    bool shared = containerFlags[offset / 4] & Container_Shared;
+    if (shared) {
+        auto it = sharedNodes.find(offset);
+        if (it != sharedNodes.end())
+            return it->second;
+    }
+
     ByamlNode node;
     node.type = NodeType::Hash;
-    node.hash = new std::map<const char*, ByamlNode>();
-    node.size = ReadU24(data+offset +1);
+    node.size = Endian::ReadU24<BigEndian>(data+offset +1);
+    node.hash = arena.AllocEntries(node.size);
     for (u64 i = 0; i < node.size; i++) {
         u32 entryOffset = offset + 4 + (i*8);
-        u32 stringIdx = ReadU24(data+entryOffset);
-        const char* hashName = hashTable[stringIdx];
+        u32 stringIdx = Endian::ReadU24<BigEndian>(data+entryOffset);
+
+        ByamlHashEntry& entry = node.hash[i];
+        entry.key = hashTable[stringIdx];
+        entry.keyIndex = stringIdx;
 
         u8 nodeType = data[entryOffset+3];
-        (*node.hash)[hashName] = ParseNode((NodeType)nodeType, entryOffset+4);
+        entry.node = ParseNode<BigEndian>((NodeType)nodeType, entryOffset+4);
+    }
+
+    if (shared) {
+        sharedNodes[offset] = node;
     }
-    
     return node;
 }
 
+template<bool BigEndian>
 ByamlNode Byaml::ParseBoolNode(u32 offset) {
     ByamlNode node;
     node.type = NodeType::Bool;
-    node.Bool = ReadU32(data+offset) != 0;
+    node.Bool = Endian::ReadU32<BigEndian>(data+offset) != 0;
     return node;
 }
 
+template<bool BigEndian>
 ByamlNode Byaml::ParseIntNode(u32 offset) {
     ByamlNode node;
     node.type = NodeType::Int;
-    node.Int = ReadS32(data+offset);
+    node.Int = Endian::ReadS32<BigEndian>(data+offset);
     return node;
 }
 
+template<bool BigEndian>
 ByamlNode Byaml::ParseFloatNode(u32 offset) {
     ByamlNode node;
     node.type = NodeType::Float;
-    node.Float = ReadFloat(data+offset);
+    node.Float = Endian::ReadFloat<BigEndian>(data+offset);
     return node;
 }
 
+template<bool BigEndian>
 ByamlNode Byaml::ParseUIntNode(u32 offset) {
     ByamlNode node;
     node.type = NodeType::UInt;
-    node.UInt = ReadU32(data+offset);
+    node.UInt = Endian::ReadU32<BigEndian>(data+offset);
     return node;
 }
 
+template<bool BigEndian>
 ByamlNode Byaml::ParseInt64Node(u32 offset) {
     ByamlNode node;
     node.type = NodeType::Int64;
-    node.Int64 = ReadS64(data+offset);
+    node.Int64 = Endian::ReadS64<BigEndian>(data+offset);
     return node;
 }
 
+template<bool BigEndian>
 ByamlNode Byaml::ParseUInt64Node(u32 offset) {
     ByamlNode node;
     node.type = NodeType::UInt64;
-    node.UInt64 = ReadU64(data+offset);
+    node.UInt64 = Endian::ReadU64<BigEndian>(data+offset);
     return node;
 }
 
+template<bool BigEndian>
 ByamlNode Byaml::ParseDoubleNode(u32 offset) {
     ByamlNode node;
     node.type = NodeType::Double;
-    node.Double = ReadDouble(data+offset);
+    node.Double = Endian::ReadDouble<BigEndian>(data+offset);
     return node;
 }
 
@@ -298,215 +600,102 @@ ByamlNode Byaml::ParseNullNode() {
 }
 
 bool Byaml::ToString(std::string& outStr) const {
-    if (IsValid()) {
-    #ifdef DEBUG
-        Print(this->parentNode, outStr, 0);
-    #endif
-        return true;
-    }
-
-    else {
+    if (!IsValid()) {
         outStr = "Not Valid!";
         return false;
     }
-}
-
-void Byaml::printTabs(u32 indent, std::string& outString, NodeType type) const {
-#ifdef DEBUG
-    outString += "├─";
-    for (u32 i = 0; i < indent; i++)
-        outString += "──";
-
-    switch (type) {
-        case NodeType::String:
-            outString += " String: ";
-            break;
 
-        case NodeType::Binary:
-            outString += " Binary: "; 
-            break;
-
-        case NodeType::Array:
-            outString += " Array:\n";
-            break;
-
-        case NodeType::Hash:
-            outString += " Hash: "; 
-            break;
-
-        case NodeType::Bool:
-            outString += " Bool: "; 
-            break;
-
-        case NodeType::Int:
-            outString += " Int: ";
-            break;
-
-        case NodeType::Float:
-            outString += " Float: "; 
-            break;
-
-        case NodeType::UInt:
-            outString += " UInt: "; 
-            break;
-
-        case NodeType::Int64:
-            outString += " Int64: "; 
-            break;
-
-        case NodeType::UInt64:
-            outString += " UInt64: "; 
-            break;
-
-        case NodeType::Double:
-            outString += " Double: "; 
-            break;
-
-        case NodeType::Null:
-            outString += ' '; 
-            break;
-
-        default:
-            break;
-    }
-#else
-    (void)indent;
-    (void)outString;
-    (void)type;
-#endif
+    outStr.clear();
+    return ToYaml(ByamlYamlEmitter::StringSink(outStr));
 }
 
-void Byaml::Print(const ByamlNode& node, std::string& outString, u32 indent) const {
-#ifdef DEBUG
-    switch (node.type) {
-        case NodeType::String:
-            printTabs(indent, outString, NodeType::String);
-            (outString += node.string) += '\n';
-            break;
-
-        case NodeType::Binary:
+void ByamlNode::Find(std::vector<ByamlNode>& outNodes, const char* keyName, bool found) {
+    switch (this->type) {
+        case NodeType::String: [[fallthrough]];
+        case NodeType::Binary: [[fallthrough]];
+        case NodeType::Bool: [[fallthrough]];
+        case NodeType::Int: [[fallthrough]];
+        case NodeType::Float: [[fallthrough]];
+        case NodeType::UInt: [[fallthrough]];
+        case NodeType::Int64: [[fallthrough]];
+        case NodeType::UInt64: [[fallthrough]];
+        case NodeType::Double: [[fallthrough]];
+        case NodeType::Null: 
             {
-                if (node.size > 0) {
-                    printTabs(indent, outString, NodeType::Binary);
-                    char byteStr[4] = {0};
-                    for (u64 i = 0; i < node.size; i++) {
-                        snprintf(byteStr, 3, "%02X", node.bytes[i]%0xFF);
-                        outString += byteStr;
-                    }
-                    outString += '\n';
-                }
+                if (found)
+                    outNodes.push_back(*this);
             }
             break;
 
         case NodeType::Array:
             {
-                for (u64 i = 0; i < node.size; i++) {
-                    printTabs(indent, outString, NodeType::Array);
-                    Print((*node.array)[i], outString, indent+1);
+                for (u64 i = 0; i < this->size; i++) {
+                    this->array[i].Find(outNodes, keyName, false);
                 }
             }
             break;
 
         case NodeType::Hash:
             {
-                for (auto elem : (*node.hash)) {
-                    printTabs(indent, outString, NodeType::Hash);
-                    (outString += elem.first) += '\n';
-                    Print(elem.second, outString, indent+1);
+                for (u64 i = 0; i < this->size; i++) {
+                    ByamlHashEntry& elem = this->hash[i];
+                    elem.node.Find(outNodes, keyName, (strcmp(elem.key, keyName) == 0));
                 }
             }
             break;
 
-        case NodeType::Bool:
-            printTabs(indent, outString, NodeType::Bool);
-            outString += (node.Bool == true ? "true\n" : "false\n");
-            break;
-
-        case NodeType::Int:
-            printTabs(indent, outString, NodeType::Int);
-            (outString += std::to_string(node.Int)) += '\n';
-            break;
-
-        case NodeType::Float:
-            printTabs(indent, outString, NodeType::Float);
-            (outString += std::to_string(node.Float)) += '\n';
-            break;
-
-        case NodeType::UInt:
-            printTabs(indent, outString, NodeType::UInt);
-            (outString += std::to_string(node.UInt)) += '\n';
-            break;
-
-        case NodeType::Int64:
-            printTabs(indent, outString, NodeType::Int64);
-            (outString += std::to_string(node.Int64)) += '\n';
-            break;
-
-        case NodeType::UInt64:
-            printTabs(indent, outString, NodeType::UInt64);
-            (outString += std::to_string(node.UInt64)) += '\n';
-            break;
-
-        case NodeType::Double:
-            printTabs(indent, outString, NodeType::Double);
-            (outString += std::to_string(node.Double)) += '\n';
-            break;
-
-        case NodeType::Null:
-            printTabs(indent, outString, NodeType::Null);
-            outString += "NULL\n";
-            break;
-
         default:
             break;
     }
-#else
-    (void)node;
-    (void)outString;
-    (void)indent;
-#endif
 }
 
-void ByamlNode::Find(std::vector<ByamlNode>& outNodes, const char* keyName, bool found) {
+void ByamlNode::FindByKeyIndex(std::vector<ByamlNode>& outNodes, u32 keyIndex, bool found) {
     switch (this->type) {
-        case NodeType::String: [[fallthrough]];
-        case NodeType::Binary: [[fallthrough]];
-        case NodeType::Bool: [[fallthrough]];
-        case NodeType::Int: [[fallthrough]];
-        case NodeType::Float: [[fallthrough]];
-        case NodeType::UInt: [[fallthrough]];
-        case NodeType::Int64: [[fallthrough]];
-        case NodeType::UInt64: [[fallthrough]];
-        case NodeType::Double: [[fallthrough]];
-        case NodeType::Null: 
-            {
-                if (found)
-                    outNodes.push_back(*this);
-            }
-            break;
-
         case NodeType::Array:
             {
                 for (u64 i = 0; i < this->size; i++) {
-                    ByamlNode node = (*(this->array))[i];
-                    node.Find(outNodes, keyName, false);
+                    this->array[i].FindByKeyIndex(outNodes, keyIndex, false);
                 }
             }
             break;
 
         case NodeType::Hash:
             {
-                for (auto elem : (*(this->hash))) {
-                    elem.second.Find(outNodes, keyName, (strcmp(elem.first, keyName) == 0));
+                for (u64 i = 0; i < this->size; i++) {
+                    ByamlHashEntry& elem = this->hash[i];
+                    elem.node.FindByKeyIndex(outNodes, keyIndex, elem.keyIndex == keyIndex);
                 }
             }
             break;
 
         default:
+            {
+                if (found)
+                    outNodes.push_back(*this);
+            }
             break;
     }
 }
 
+const ByamlNode* ByamlNode::GetByKeyIndex(u32 keyIndex) const {
+    if (this->type != NodeType::Hash)
+        return nullptr;
+
+    u64 low = 0, high = this->size;
+    while (low < high) {
+        u64 mid = low + ((high - low) / 2);
+        u32 midIndex = this->hash[mid].keyIndex;
+        if (midIndex == keyIndex)
+            return &this->hash[mid].node;
+
+        if (midIndex < keyIndex)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return nullptr;
+}
+
 std::vector<ByamlNode> ByamlNode::operator[](const char* keyName) {
     std::vector<ByamlNode> nodes;
     this->Find(nodes, keyName, false);
@@ -515,6 +704,9 @@ std::vector<ByamlNode> ByamlNode::operator[](const char* keyName) {
 
 std::vector<ByamlNode> Byaml::operator[](const char* keyName) {
     std::vector<ByamlNode> nodes;
-    parentNode.Find(nodes, keyName, false);
+    u32 keyIndex = 0;
+    if (GetKeyIndex(keyName, keyIndex)) { //Keys missing from the table can't match anything
+        parentNode.FindByKeyIndex(nodes, keyIndex, false);
+    }
     return nodes;
 }
\ No newline at end of file
@@ -0,0 +1,331 @@
+/**
+ *
+ * ByamlPatch.cpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+
+#include "ByamlPatch.hpp"
+#include "ByamlQuery.hpp"
+#include "MemoryMap.hpp"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+static inline bool Is64Bit(NodeType type) {
+    return type == NodeType::Int64 || type == NodeType::UInt64 || type == NodeType::Double;
+}
+
+ByamlPatch::ByamlPatch(Byaml& byaml, bool checkShared) : byaml(byaml), checkShared(checkShared) {
+    if (!byaml.IsValid()) {
+        InValidate("Invalid Byaml");
+        return;
+    }
+
+    if (byaml.autoUnmapMem && !MemoryMap::MakeWritable(byaml.data, byaml.dataSize)) {
+        InValidate("Failed to make mapped data writable");
+    }
+}
+
+bool ByamlPatch::IsValid() const {
+    return isValid;
+}
+
+const char* ByamlPatch::GetErrorMessage() const {
+    return errorMessage;
+}
+
+ByamlView ByamlPatch::Find(const char* path) const {
+    if (!IsValid() || path == nullptr)
+        return ByamlView();
+
+    ByamlQuery query(path);
+    if (!query.IsValid())
+        return ByamlView();
+
+    return query.First(byaml.GetRoot());
+}
+
+bool ByamlPatch::HasFlag(u32 offset, u8 flag) const {
+    return (offset / 4) < flags.size() && (flags[offset / 4] & flag) != 0;
+}
+
+void ByamlPatch::MarkShared(const ByamlView& container) { //Everything below a shared container is shared too
+    std::vector<ByamlView> stack{ container };
+    while (!stack.empty()) {
+        ByamlView view = stack.back();
+        stack.pop_back();
+
+        u8& flag = flags[view.nodeOffset / 4];
+        if (flag & Flag_Shared)
+            continue;
+        flag |= Flag_Visited | Flag_Shared;
+
+        for (u32 i = 0; i < view.GetSize(); i++) {
+            ByamlView child = view.At(i);
+            flags[child.valueOffset / 4] |= Flag_SharedSlot;
+            if (child.IsArray() || child.IsHash())
+                stack.push_back(child);
+            else if (Is64Bit(child.type) && static_cast<u64>(child.nodeOffset) + 8 <= byaml.dataSize)
+                flags[child.nodeOffset / 4] |= Flag_Visited | Flag_Shared;
+        }
+    }
+}
+
+bool ByamlPatch::BuildSharedIndex() {
+    ByamlView root = byaml.GetRoot();
+    if (!root.IsArray() && !root.IsHash())
+        return false;
+
+    //Each container is walked once; reaching one again marks it (and what's below it) as shared.
+    //Cycles are reached again too, so they end up shared and are never patched.
+    flags.assign((byaml.dataSize / 4) + 1, 0);
+    flags[root.nodeOffset / 4] |= Flag_Visited;
+    std::vector<ByamlView> stack{ root };
+    while (!stack.empty()) {
+        ByamlView view = stack.back();
+        stack.pop_back();
+
+        for (u32 i = 0; i < view.GetSize(); i++) {
+            ByamlView child = view.At(i);
+            bool isContainer = child.IsArray() || child.IsHash();
+            if (!isContainer && !Is64Bit(child.type))
+                continue;
+
+            if (!isContainer && static_cast<u64>(child.nodeOffset) + 8 > byaml.dataSize)
+                continue;
+
+            u8& flag = flags[child.nodeOffset / 4];
+            if (flag & Flag_Visited) {
+                if (isContainer)
+                    MarkShared(child);
+                else
+                    flag |= Flag_Shared;
+                continue;
+            }
+
+            flag |= Flag_Visited;
+            if (isContainer)
+                stack.push_back(child);
+        }
+    }
+
+    sharedIndexBuilt = true;
+    return true;
+}
+
+void ByamlPatch::BuildDataOffsets() { //Only needed to repoint shared values, so only built then
+    std::vector<bool> visited((byaml.dataSize / 4) + 1, false);
+    std::vector<ByamlView> stack{ byaml.GetRoot() };
+    while (!stack.empty()) {
+        ByamlView view = stack.back();
+        stack.pop_back();
+        if (visited[view.nodeOffset / 4])
+            continue;
+        visited[view.nodeOffset / 4] = true;
+
+        for (u32 i = 0; i < view.GetSize(); i++) {
+            ByamlView child = view.At(i);
+            if (child.IsArray() || child.IsHash())
+                stack.push_back(child);
+            else if (Is64Bit(child.type) && static_cast<u64>(child.nodeOffset) + 8 <= byaml.dataSize)
+                dataOffsets.emplace(byaml.ReadU64(byaml.data+child.nodeOffset), child.nodeOffset);
+        }
+    }
+    dataOffsetsBuilt = true;
+}
+
+bool ByamlPatch::CheckNode(const ByamlView& node, NodeType type) {
+    if (!IsValid())
+        return Fail(errorMessage);
+
+    if (node.byaml != &byaml || !node.IsValid())
+        return Fail("Node isn't from this Byaml");
+
+    if (node.type != type)
+        return Fail("Node type mismatch");
+
+    if (static_cast<u64>(node.valueOffset) + 4 > byaml.dataSize)
+        return Fail("Node out of bounds");
+
+    if (checkShared) {
+        if (!sharedIndexBuilt && !BuildSharedIndex())
+            return Fail("Invalid container layout");
+
+        if (HasFlag(node.valueOffset, Flag_SharedSlot))
+            return Fail("Node is shared with other paths");
+    }
+    return true;
+}
+
+bool ByamlPatch::Set32(const ByamlView& node, NodeType type, u32 value) {
+    if (!CheckNode(node, type))
+        return false;
+
+    WriteU32(node.valueOffset, value);
+    return true;
+}
+
+bool ByamlPatch::Set64(const ByamlView& node, NodeType type, u64 value) {
+    if (!CheckNode(node, type))
+        return false;
+
+    u32 offset = node.nodeOffset;
+    if (static_cast<u64>(offset) + 8 > byaml.dataSize)
+        return Fail("Node out of bounds");
+
+    u64 oldValue = byaml.ReadU64(byaml.data+offset);
+    if (oldValue == value)
+        return true;
+
+    if (!checkShared) {
+        WriteU64(offset, value);
+        return true;
+    }
+
+    if (!HasFlag(offset, Flag_Shared)) { //Only this node points here
+        if (dataOffsetsBuilt) {
+            auto old = dataOffsets.find(oldValue);
+            if (old != dataOffsets.end() && old->second == offset)
+                dataOffsets.erase(old);
+            dataOffsets.emplace(value, offset);
+        }
+
+        WriteU64(offset, value);
+        return true;
+    }
+
+    //Other nodes read the same 8 bytes, so point this one at another copy of the value instead
+    if (!dataOffsetsBuilt)
+        BuildDataOffsets();
+
+    auto existing = dataOffsets.find(value);
+    if (existing == dataOffsets.end())
+        return Fail("Value is shared with other nodes and the new value isn't in the file");
+
+    flags[existing->second / 4] |= Flag_Shared;
+    WriteU32(node.valueOffset, existing->second);
+    return true;
+}
+
+void ByamlPatch::WriteU32(u32 offset, u32 value) {
+    if (byaml.bigEndian)
+        Endian::WriteU32<true>(byaml.data+offset, value);
+    else
+        Endian::WriteU32<false>(byaml.data+offset, value);
+    MarkDirty(offset, 4);
+}
+
+void ByamlPatch::WriteU64(u32 offset, u64 value) {
+    if (byaml.bigEndian)
+        Endian::WriteU64<true>(byaml.data+offset, value);
+    else
+        Endian::WriteU64<false>(byaml.data+offset, value);
+    MarkDirty(offset, 8);
+}
+
+void ByamlPatch::MarkDirty(u64 offset, u64 size) {
+    auto it = std::lower_bound(dirtyRanges.begin(), dirtyRanges.end(), offset,
+        [](const ByamlDirtyRange& range, u64 value) { return range.offset < value; });
+
+    if (it != dirtyRanges.begin() && (it - 1)->offset + (it - 1)->size >= offset)
+        --it; //Touches the previous range
+    else
+        it = dirtyRanges.insert(it, { offset, size });
+
+    u64 end = std::max(it->offset + it->size, offset + size);
+    it->offset = std::min(it->offset, offset);
+
+    auto next = it + 1;
+    while (next != dirtyRanges.end() && next->offset <= end) {
+        end = std::max(end, next->offset + next->size);
+        ++next;
+    }
+    it->size = end - it->offset;
+    dirtyRanges.erase(it + 1, next);
+}
+
+bool ByamlPatch::SetBool(const ByamlView& node, bool value) {
+    return Set32(node, NodeType::Bool, value ? 1 : 0);
+}
+
+bool ByamlPatch::SetInt(const ByamlView& node, s32 value) {
+    return Set32(node, NodeType::Int, static_cast<u32>(value));
+}
+
+bool ByamlPatch::SetUInt(const ByamlView& node, u32 value) {
+    return Set32(node, NodeType::UInt, value);
+}
+
+bool ByamlPatch::SetFloat(const ByamlView& node, float value) {
+    u32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return Set32(node, NodeType::Float, bits);
+}
+
+bool ByamlPatch::SetInt64(const ByamlView& node, s64 value) {
+    return Set64(node, NodeType::Int64, static_cast<u64>(value));
+}
+
+bool ByamlPatch::SetUInt64(const ByamlView& node, u64 value) {
+    return Set64(node, NodeType::UInt64, value);
+}
+
+bool ByamlPatch::SetDouble(const ByamlView& node, double value) {
+    u64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return Set64(node, NodeType::Double, bits);
+}
+
+bool ByamlPatch::SetString(const ByamlView& node, const char* value) {
+    u32 index = 0;
+    if (value == nullptr || !byaml.GetStringIndex(value, index))
+        return Fail("String isn't in the string table");
+
+    return Set32(node, NodeType::String, index);
+}
+
+const std::vector<ByamlDirtyRange>& ByamlPatch::GetDirtyRanges() const {
+    return dirtyRanges;
+}
+
+void ByamlPatch::ClearDirtyRanges() {
+    dirtyRanges.clear();
+}
+
+bool ByamlPatch::WriteDirty(const char* filePath) const {
+    if (!IsValid() || filePath == nullptr)
+        return false;
+
+    FILE* file = fopen(filePath, "r+b");
+    if (file == NULL)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    bool res = static_cast<u64>(ftell(file)) == byaml.dataSize; //Must be the same file
+    for (size_t i = 0; res && i < dirtyRanges.size(); i++) {
+        const ByamlDirtyRange& range = dirtyRanges[i];
+        res = fseek(file, static_cast<long>(range.offset), SEEK_SET) == 0 &&
+            fwrite(byaml.data+range.offset, sizeof(u8), range.size, file) == range.size;
+    }
+
+    if (fclose(file) != 0)
+        res = false;
+    return res;
+}
@@ -0,0 +1,434 @@
+/**
+ *
+ * ByamlQuery.cpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#include "ByamlQuery.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+static const constexpr u32 NoKeyIndex = 0xFFFFFFFF;
+static const constexpr u32 MaxQueryDepth = 0x100; //Guards '**' against offset cycles in views
+
+/* Node adapters, so one step runner handles both the parsed tree and views */
+
+static ALWAYS_INLINE NodeType TypeOf(const ByamlNode& node) {
+    return node.type;
+}
+
+static ALWAYS_INLINE NodeType TypeOf(const ByamlView& view) {
+    return view.IsValid() ? view.GetType() : NodeType::Null;
+}
+
+static ALWAYS_INLINE u64 ChildCount(const ByamlNode& node) {
+    return (node.type == NodeType::Array || node.type == NodeType::Hash) ? node.size : 0;
+}
+
+static ALWAYS_INLINE u64 ChildCount(const ByamlView& view) {
+    return view.GetSize();
+}
+
+static ALWAYS_INLINE const ByamlNode& Child(const ByamlNode& node, u64 index) {
+    return (node.type == NodeType::Array) ? node.array[index] : node.hash[index].node;
+}
+
+static ALWAYS_INLINE ByamlView Child(const ByamlView& view, u64 index) {
+    return view.At(static_cast<u32>(index));
+}
+
+static ALWAYS_INLINE const ByamlNode* KeyChild(const ByamlNode& node, u32 keyIndex) {
+    return node.GetByKeyIndex(keyIndex);
+}
+
+static ALWAYS_INLINE ByamlView KeyChild(const ByamlView& view, u32 keyIndex) {
+    return view.GetByKeyIndex(keyIndex);
+}
+
+static ALWAYS_INLINE bool IsFound(const ByamlNode* node) {
+    return node != nullptr;
+}
+
+static ALWAYS_INLINE bool IsFound(const ByamlView& view) {
+    return view.IsValid();
+}
+
+static ALWAYS_INLINE const ByamlNode& Deref(const ByamlNode* node) {
+    return *node;
+}
+
+static ALWAYS_INLINE const ByamlView& Deref(const ByamlView& view) {
+    return view;
+}
+
+//Reads any integer/bool node as a 64-bit value; isUnsigned is set for UInt64 values above INT64_MAX
+static bool ReadInteger(const ByamlNode& node, s64& outValue, bool& outUnsigned) {
+    outUnsigned = false;
+    switch (node.type) {
+        case NodeType::Bool: outValue = node.Bool ? 1 : 0; return true;
+        case NodeType::Int: outValue = node.Int; return true;
+        case NodeType::UInt: outValue = node.UInt; return true;
+        case NodeType::Int64: outValue = node.Int64; return true;
+        case NodeType::UInt64: outValue = static_cast<s64>(node.UInt64); outUnsigned = node.UInt64 > 0x7FFFFFFFFFFFFFFFULL; return true;
+        default: return false;
+    }
+}
+
+static bool ReadInteger(const ByamlView& view, s64& outValue, bool& outUnsigned) {
+    outUnsigned = false;
+    bool boolValue; s32 intValue; u32 uintValue; u64 uint64Value;
+    switch (TypeOf(view)) {
+        case NodeType::Bool: if (!view.GetBool(boolValue)) return false; outValue = boolValue ? 1 : 0; return true;
+        case NodeType::Int: if (!view.GetInt(intValue)) return false; outValue = intValue; return true;
+        case NodeType::UInt: if (!view.GetUInt(uintValue)) return false; outValue = uintValue; return true;
+        case NodeType::Int64: return view.GetInt64(outValue);
+        case NodeType::UInt64:
+            if (!view.GetUInt64(uint64Value)) return false;
+            outValue = static_cast<s64>(uint64Value);
+            outUnsigned = uint64Value > 0x7FFFFFFFFFFFFFFFULL;
+            return true;
+        default: return false;
+    }
+}
+
+static bool ReadFloating(const ByamlNode& node, double& outValue, bool& outSingle) {
+    outSingle = node.type == NodeType::Float;
+    switch (node.type) {
+        case NodeType::Float: outValue = node.Float; return true;
+        case NodeType::Double: outValue = node.Double; return true;
+        default: return false;
+    }
+}
+
+static bool ReadFloating(const ByamlView& view, double& outValue, bool& outSingle) {
+    float floatValue;
+    outSingle = TypeOf(view) == NodeType::Float;
+    switch (TypeOf(view)) {
+        case NodeType::Float: if (!view.GetFloat(floatValue)) return false; outValue = floatValue; return true;
+        case NodeType::Double: return view.GetDouble(outValue);
+        default: return false;
+    }
+}
+
+static bool ReadString(const ByamlNode& node, const char*& outValue) {
+    if (node.type != NodeType::String)
+        return false;
+
+    outValue = node.string;
+    return true;
+}
+
+static bool ReadString(const ByamlView& view, const char*& outValue) {
+    return view.GetString(outValue);
+}
+
+ByamlQuery::ByamlQuery(const char* path) {
+    if (path == nullptr) {
+        InValidate("Invalid path");
+        return;
+    }
+
+    const char* pos = path;
+    bool first = true;
+    while (*pos != '\0') {
+        const char* end = strchr(pos, '/');
+        if (end == nullptr)
+            end = pos + strlen(pos);
+
+        std::string segment(pos, end - pos);
+        pos = (*end == '/') ? end + 1 : end;
+        if (segment.empty())
+            continue;
+
+        if (first && segment == "Root") { //Optional, stands for the start node
+            first = false;
+            continue;
+        }
+        first = false;
+
+        Step step;
+        if (segment == "**") {
+            step.type = StepType::Descendants;
+        }
+        else if (segment == "*" || segment == "[*]") {
+            step.type = StepType::All;
+        }
+        else if (segment.front() == '[' && segment.back() == ']') {
+            std::string expression = segment.substr(1, segment.size() - 2);
+            if (expression.find('=') != std::string::npos) {
+                step.type = StepType::Filter;
+                if (!ParseFilter(step, expression))
+                    return;
+            }
+            else {
+                char* numberEnd = nullptr;
+                errno = 0;
+                unsigned long long index = strtoull(expression.c_str(), &numberEnd, 0);
+                if (expression.empty() || *numberEnd != '\0' || errno != 0 || index > 0xFFFFFF) {
+                    InValidate("Invalid index");
+                    return;
+                }
+                step.type = StepType::Index;
+                step.index = static_cast<u32>(index);
+            }
+        }
+        else {
+            step.type = StepType::Key;
+            step.key = segment;
+        }
+
+        if (steps.size() == MaxSteps) {
+            InValidate("Too many steps");
+            return;
+        }
+        steps.push_back(std::move(step));
+    }
+}
+
+bool ByamlQuery::ParseFilter(Step& step, const std::string& expression) {
+    size_t split = expression.find('=');
+    step.key = expression.substr(0, split);
+    std::string value = expression.substr(split + 1);
+    if (step.key.empty() || value.empty()) {
+        InValidate("Invalid filter");
+        return false;
+    }
+
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+        step.valueType = ValueType::String;
+        step.stringValue = value.substr(1, value.size() - 2);
+        return true;
+    }
+
+    if (value == "true" || value == "false") {
+        step.valueType = ValueType::Bool;
+        step.intValue = (value == "true") ? 1 : 0;
+        return true;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    if (value.front() == '-') {
+        step.intValue = strtoll(value.c_str(), &end, 0);
+    }
+    else {
+        unsigned long long uvalue = strtoull(value.c_str(), &end, 0);
+        step.intValue = static_cast<s64>(uvalue);
+        step.intUnsigned = uvalue > 0x7FFFFFFFFFFFFFFFULL;
+    }
+
+    if (*end == '\0' && errno == 0) {
+        step.valueType = ValueType::Integer;
+        return true;
+    }
+
+    errno = 0;
+    step.floatValue = strtod(value.c_str(), &end);
+    if (*end == '\0' && errno == 0) {
+        step.valueType = ValueType::Float;
+        return true;
+    }
+
+    step.valueType = ValueType::String; //Unquoted strings are fine too
+    step.stringValue = value;
+    return true;
+}
+
+bool ByamlQuery::IsValid() const {
+    return isValid;
+}
+
+const char* ByamlQuery::GetErrorMessage() const {
+    return errorMessage;
+}
+
+u32 ByamlQuery::GetStepCount() const {
+    return static_cast<u32>(steps.size());
+}
+
+bool ByamlQuery::ResolveKeys(const Byaml& byaml, u32* outKeyIndices) const {
+    for (u32 i = 0; i < steps.size(); i++) {
+        outKeyIndices[i] = NoKeyIndex;
+        if (steps[i].type != StepType::Key && steps[i].type != StepType::Filter)
+            continue;
+
+        if (!byaml.GetKeyIndex(steps[i].key.c_str(), outKeyIndices[i])) //Key isn't in the file, so nothing can match
+            return false;
+    }
+    return true;
+}
+
+template <typename Node>
+bool ByamlQuery::MatchValue(const Node& node, const Step& step) {
+    switch (step.valueType) {
+        case ValueType::Integer: [[fallthrough]];
+        case ValueType::Bool:
+            {
+                s64 value = 0;
+                bool isUnsigned = false;
+                if (ReadInteger(node, value, isUnsigned))
+                    return value == step.intValue && isUnsigned == step.intUnsigned;
+
+                double floating = 0;
+                bool single = false;
+                return step.valueType == ValueType::Integer && ReadFloating(node, floating, single) &&
+                    floating == (step.intUnsigned ? static_cast<double>(static_cast<u64>(step.intValue)) : static_cast<double>(step.intValue));
+            }
+
+        case ValueType::Float:
+            {
+                double value = 0;
+                bool single = false;
+                if (!ReadFloating(node, value, single))
+                    return false;
+                return single ? (static_cast<float>(value) == static_cast<float>(step.floatValue)) : (value == step.floatValue);
+            }
+
+        case ValueType::String:
+            {
+                const char* value = nullptr;
+                return ReadString(node, value) && step.stringValue == value;
+            }
+
+        default:
+            return false;
+    }
+}
+
+template <typename Node, typename Callback>
+bool ByamlQuery::RunStep(const u32* keyIndices, u32 stepIndex, u32 depth, const Node& node, const Callback& callback, u64& matchCount) const {
+    if (stepIndex == steps.size()) {
+        matchCount++;
+        return callback(node);
+    }
+
+    if (depth > MaxQueryDepth)
+        return true;
+
+    const Step& step = steps[stepIndex];
+    switch (step.type) {
+        case StepType::Key:
+            {
+                if (TypeOf(node) != NodeType::Hash || keyIndices[stepIndex] == NoKeyIndex)
+                    return true;
+
+                auto child = KeyChild(node, keyIndices[stepIndex]);
+                if (!IsFound(child))
+                    return true;
+                return RunStep(keyIndices, stepIndex + 1, depth + 1, Deref(child), callback, matchCount);
+            }
+
+        case StepType::Index:
+            {
+                if (step.index >= ChildCount(node))
+                    return true;
+                return RunStep(keyIndices, stepIndex + 1, depth + 1, Child(node, step.index), callback, matchCount);
+            }
+
+        case StepType::All:
+            {
+                u64 count = ChildCount(node);
+                for (u64 i = 0; i < count; i++) {
+                    if (!RunStep(keyIndices, stepIndex + 1, depth + 1, Child(node, i), callback, matchCount))
+                        return false;
+                }
+                return true;
+            }
+
+        case StepType::Filter:
+            {
+                if (keyIndices[stepIndex] == NoKeyIndex)
+                    return true;
+
+                u64 count = ChildCount(node);
+                for (u64 i = 0; i < count; i++) {
+                    auto&& child = Child(node, i);
+                    if (TypeOf(child) != NodeType::Hash)
+                        continue;
+
+                    auto value = KeyChild(child, keyIndices[stepIndex]);
+                    if (!IsFound(value) || !MatchValue(Deref(value), step))
+                        continue;
+
+                    if (!RunStep(keyIndices, stepIndex + 1, depth + 1, child, callback, matchCount))
+                        return false;
+                }
+                return true;
+            }
+
+        case StepType::Descendants:
+            {
+                if (!RunStep(keyIndices, stepIndex + 1, depth, node, callback, matchCount))
+                    return false;
+
+                u64 count = ChildCount(node);
+                for (u64 i = 0; i < count; i++) {
+                    if (!RunStep(keyIndices, stepIndex, depth + 1, Child(node, i), callback, matchCount))
+                        return false;
+                }
+                return true;
+            }
+
+        default:
+            return true;
+    }
+}
+
+u64 ByamlQuery::Run(const Byaml& byaml, const std::function<bool(const ByamlNode&)>& callback) const {
+    return Run(byaml, byaml.GetRootNode(), callback);
+}
+
+u64 ByamlQuery::Run(const Byaml& byaml, const ByamlNode& from, const std::function<bool(const ByamlNode&)>& callback) const {
+    u32 keyIndices[MaxSteps];
+    if (!IsValid() || !byaml.IsValid() || !byaml.IsParsed() || !ResolveKeys(byaml, keyIndices))
+        return 0;
+
+    u64 matchCount = 0;
+    RunStep(keyIndices, 0, 0, from, callback, matchCount);
+    return matchCount;
+}
+
+u64 ByamlQuery::Run(const ByamlView& from, const std::function<bool(const ByamlView&)>& callback) const {
+    u32 keyIndices[MaxSteps];
+    if (!IsValid() || !from.IsValid() || !ResolveKeys(*from.byaml, keyIndices))
+        return 0;
+
+    u64 matchCount = 0;
+    RunStep(keyIndices, 0, 0, from, callback, matchCount);
+    return matchCount;
+}
+
+const ByamlNode* ByamlQuery::First(const Byaml& byaml) const {
+    const ByamlNode* res = nullptr;
+    Run(byaml, [&res](const ByamlNode& node) {
+        res = &node;
+        return false;
+    });
+    return res;
+}
+
+ByamlView ByamlQuery::First(const ByamlView& from) const {
+    ByamlView res;
+    Run(from, [&res](const ByamlView& view) {
+        res = view;
+        return false;
+    });
+    return res;
+}
@@ -0,0 +1,207 @@
+/**
+ *
+ * ByamlView.cpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#include "Byaml.hpp"
+#include <cstring>
+
+ByamlView::ByamlView(const Byaml* byaml, NodeType type, u32 valueOffset) : byaml(byaml), type(type), valueOffset(valueOffset) {
+    switch (type) {
+        case NodeType::Array: [[fallthrough]];
+        case NodeType::Hash: [[fallthrough]];
+        case NodeType::Binary: [[fallthrough]];
+        case NodeType::Int64: [[fallthrough]];
+        case NodeType::UInt64: [[fallthrough]];
+        case NodeType::Double:
+            this->nodeOffset = byaml->ReadU32(byaml->data+valueOffset);
+            break;
+
+        default:
+            break;
+    }
+
+    if ((type == NodeType::Array || type == NodeType::Hash) && !CheckContainer()) {
+        this->byaml = nullptr;
+        this->type = NodeType::Null;
+    }
+}
+
+bool ByamlView::CheckContainer() const { //Header and entries must be inside the file
+    if (static_cast<u64>(nodeOffset) + 4 > byaml->dataSize || (NodeType)byaml->data[nodeOffset] != type)
+        return false;
+
+    u64 size = byaml->ReadU24(byaml->data+nodeOffset+1);
+    u64 end = (type == NodeType::Array) ? (nodeOffset + 4 + (((size + 3) / 4) * 4) + (size * 4)) : (nodeOffset + 4 + (size * 8));
+    return end <= byaml->dataSize;
+}
+
+bool ByamlView::IsValid() const {
+    return byaml != nullptr;
+}
+
+NodeType ByamlView::GetType() const {
+    return type;
+}
+
+bool ByamlView::IsArray() const {
+    return IsValid() && type == NodeType::Array;
+}
+
+bool ByamlView::IsHash() const {
+    return IsValid() && type == NodeType::Hash;
+}
+
+u32 ByamlView::GetSize() const {
+    if (!IsArray() && !IsHash())
+        return 0;
+
+    return byaml->ReadU24(byaml->data+nodeOffset+1);
+}
+
+ByamlView ByamlView::At(u32 index) const {
+    if (index >= GetSize())
+        return ByamlView();
+
+    if (type == NodeType::Array) {
+        u32 size = GetSize();
+        NodeType childType = (NodeType)byaml->data[nodeOffset+4+index];
+        return ByamlView(byaml, childType, nodeOffset + 4 + (((size + 3) / 4) * 4) + (index * 4));
+    }
+
+    u32 entryOffset = nodeOffset + 4 + (index * 8);
+    return ByamlView(byaml, (NodeType)byaml->data[entryOffset+3], entryOffset+4);
+}
+
+const char* ByamlView::GetKey(u32 index) const {
+    if (!IsHash() || index >= GetSize())
+        return nullptr;
+
+    u32 keyIndex = byaml->ReadU24(byaml->data+nodeOffset+4+(index*8));
+    return byaml->ReadTableString(byaml->hashKeyTableOffset, keyIndex);
+}
+
+ByamlView ByamlView::Get(const char* key) const {
+    u32 keyIndex = 0;
+    if (!IsHash() || !byaml->GetKeyIndex(key, keyIndex))
+        return ByamlView();
+
+    return GetByKeyIndex(keyIndex);
+}
+
+ByamlView ByamlView::GetByKeyIndex(u32 keyIndex) const {
+    if (!IsHash())
+        return ByamlView();
+
+    u32 low = 0, high = GetSize();
+    while (low < high) {
+        u32 mid = low + ((high - low) / 2);
+        u32 midIndex = byaml->ReadU24(byaml->data+nodeOffset+4+(mid*8));
+        if (midIndex == keyIndex)
+            return At(mid);
+
+        if (midIndex < keyIndex)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return ByamlView();
+}
+
+bool ByamlView::GetBool(bool& outValue) const {
+    if (!IsValid() || type != NodeType::Bool)
+        return false;
+
+    outValue = byaml->ReadU32(byaml->data+valueOffset) != 0;
+    return true;
+}
+
+bool ByamlView::GetInt(s32& outValue) const {
+    if (!IsValid() || type != NodeType::Int)
+        return false;
+
+    outValue = byaml->ReadS32(byaml->data+valueOffset);
+    return true;
+}
+
+bool ByamlView::GetUInt(u32& outValue) const {
+    if (!IsValid() || type != NodeType::UInt)
+        return false;
+
+    outValue = byaml->ReadU32(byaml->data+valueOffset);
+    return true;
+}
+
+bool ByamlView::GetFloat(float& outValue) const {
+    if (!IsValid() || type != NodeType::Float)
+        return false;
+
+    outValue = byaml->ReadFloat(byaml->data+valueOffset);
+    return true;
+}
+
+bool ByamlView::GetInt64(s64& outValue) const {
+    if (!IsValid() || type != NodeType::Int64 || static_cast<u64>(nodeOffset) + 8 > byaml->dataSize)
+        return false;
+
+    outValue = byaml->ReadS64(byaml->data+nodeOffset);
+    return true;
+}
+
+bool ByamlView::GetUInt64(u64& outValue) const {
+    if (!IsValid() || type != NodeType::UInt64 || static_cast<u64>(nodeOffset) + 8 > byaml->dataSize)
+        return false;
+
+    outValue = byaml->ReadU64(byaml->data+nodeOffset);
+    return true;
+}
+
+bool ByamlView::GetDouble(double& outValue) const {
+    if (!IsValid() || type != NodeType::Double || static_cast<u64>(nodeOffset) + 8 > byaml->dataSize)
+        return false;
+
+    outValue = byaml->ReadDouble(byaml->data+nodeOffset);
+    return true;
+}
+
+bool ByamlView::GetString(const char*& outValue) const {
+    if (!IsValid() || type != NodeType::String)
+        return false;
+
+    const char* string = byaml->ReadTableString(byaml->stringTableOffset, byaml->ReadU32(byaml->data+valueOffset));
+    if (string == nullptr)
+        return false;
+
+    outValue = string;
+    return true;
+}
+
+bool ByamlView::GetBinary(const u8*& outData, u32& outSize) const {
+    if (!IsValid() || type != NodeType::Binary || static_cast<u64>(nodeOffset) + 4 > byaml->dataSize)
+        return false;
+
+    u32 size = byaml->ReadU32(byaml->data+nodeOffset);
+    if (static_cast<u64>(nodeOffset) + 4 + size > byaml->dataSize)
+        return false;
+
+    outData = byaml->data+nodeOffset+4;
+    outSize = size;
+    return true;
+}
@@ -0,0 +1,692 @@
+/**
+ *
+ * ByamlWriter.cpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#include "ByamlWriter.hpp"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+static const constexpr u32 HeaderSize = 0x10;
+static const constexpr u32 MaxContainerDepth = 0x100; //Same limit as the parser
+static const constexpr u32 MaxCount = 0xFFFFFF; //Container and table counts are u24
+static const constexpr u32 InvalidHandle = static_cast<u32>(-1);
+
+static ALWAYS_INLINE u32 AlignUp(u32 value, u32 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static ALWAYS_INLINE void WriteU16(u8* out, u16 val) {
+    out[0] = val & 0xFF;
+    out[1] = val >> 8;
+}
+
+static ALWAYS_INLINE void WriteU24(u8* out, u32 val) {
+    WriteU16(out, val & 0xFFFF);
+    out[2] = (val >> 16) & 0xFF;
+}
+
+static ALWAYS_INLINE void WriteU32(u8* out, u32 val) {
+    WriteU16(out, val & 0xFFFF);
+    WriteU16(out + 2, val >> 16);
+}
+
+static ALWAYS_INLINE void WriteU64(u8* out, u64 val) {
+    WriteU32(out, val & 0xFFFFFFFF);
+    WriteU32(out + 4, val >> 32);
+}
+
+static ALWAYS_INLINE bool IsContainer(NodeType type) {
+    return type == NodeType::Array || type == NodeType::Hash;
+}
+
+static ALWAYS_INLINE bool IsOutOfLine(NodeType type) { //Value is an offset to the node's data
+    return IsContainer(type) || type == NodeType::Binary || type == NodeType::Int64 ||
+        type == NodeType::UInt64 || type == NodeType::Double;
+}
+
+static ALWAYS_INLINE u64 MixHash(u64 hash, u64 value) {
+    hash ^= value + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+    return hash * 0xFF51AFD7ED558CCDULL;
+}
+
+static ALWAYS_INLINE u64 FinalizeHash(u64 hash) { //MurmurHash3 fmix64, so the low bits (the slot) depend on every bit
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    return hash ^ (hash >> 33);
+}
+
+ByamlWriter::ByamlWriter(u16 version) : version(version) {
+    if (version < 2 || version > 4)
+        InValidate("Unsupported version");
+}
+
+bool ByamlWriter::IsValid() const {
+    return isValid;
+}
+
+const char* ByamlWriter::GetErrorMessage() const {
+    return errorMessage;
+}
+
+u16 ByamlWriter::GetVersion() const {
+    return version;
+}
+
+u32 ByamlWriter::GetNodeCount() const {
+    return static_cast<u32>(nodes.size());
+}
+
+u32 ByamlWriter::AddNode(NodeType type, u64 value) {
+    ByamlWriterNode node;
+    node.type = type;
+    node.value = value;
+    node.keysAdded = false;
+    nodes.push_back(std::move(node));
+    layoutDirty = true;
+    return static_cast<u32>(nodes.size() - 1);
+}
+
+u32 ByamlWriter::Intern(std::unordered_map<std::string, u32>& indices, std::vector<std::string>& pool, const char* data, u64 size) {
+    std::string str(data, size);
+    auto it = indices.find(str);
+    if (it != indices.end())
+        return it->second;
+
+    u32 index = static_cast<u32>(pool.size());
+    indices.emplace(str, index);
+    pool.push_back(std::move(str));
+    return index;
+}
+
+u32 ByamlWriter::AddNull() {
+    return AddNode(NodeType::Null, 0);
+}
+
+u32 ByamlWriter::AddBool(bool value) {
+    return AddNode(NodeType::Bool, value ? 1 : 0);
+}
+
+u32 ByamlWriter::AddInt(s32 value) {
+    return AddNode(NodeType::Int, static_cast<u32>(value));
+}
+
+u32 ByamlWriter::AddUInt(u32 value) {
+    return AddNode(NodeType::UInt, value);
+}
+
+u32 ByamlWriter::AddFloat(float value) {
+    u32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return AddNode(NodeType::Float, bits);
+}
+
+u32 ByamlWriter::AddInt64(s64 value) {
+    return AddNode(NodeType::Int64, static_cast<u64>(value));
+}
+
+u32 ByamlWriter::AddUInt64(u64 value) {
+    return AddNode(NodeType::UInt64, value);
+}
+
+u32 ByamlWriter::AddDouble(double value) {
+    u64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return AddNode(NodeType::Double, bits);
+}
+
+u32 ByamlWriter::AddString(const char* value) {
+    if (value == nullptr)
+        value = "";
+    return AddNode(NodeType::String, Intern(stringIndices, stringPool, value, strlen(value)));
+}
+
+u32 ByamlWriter::AddBinary(const u8* data, u32 size) {
+    if (data == nullptr)
+        size = 0;
+    return AddNode(NodeType::Binary, Intern(binaryIndices, binaryPool, data ? reinterpret_cast<const char*>(data) : "", size));
+}
+
+u32 ByamlWriter::AddArray() {
+    return AddNode(NodeType::Array, 0);
+}
+
+u32 ByamlWriter::AddHash() {
+    return AddNode(NodeType::Hash, 0);
+}
+
+static u64 CountNodes(const ByamlNode& node) {
+    u64 count = 1;
+    if (node.type == NodeType::Array) {
+        for (u64 i = 0; i < node.size; i++)
+            count += CountNodes(node.array[i]);
+    }
+    else if (node.type == NodeType::Hash) {
+        for (u64 i = 0; i < node.size; i++)
+            count += CountNodes(node.hash[i].node);
+    }
+    return count;
+}
+
+u32 ByamlWriter::AddNode(const ByamlNode& node) {
+    nodes.reserve(nodes.size() + CountNodes(node));
+    return ImportNode(node);
+}
+
+u32 ByamlWriter::ImportNode(const ByamlNode& node) {
+    switch (node.type) {
+        case NodeType::String:
+            return AddString(node.string);
+
+        case NodeType::Binary:
+            return AddBinary(node.bytes, static_cast<u32>(node.size));
+
+        case NodeType::Array: {
+            u32 array = AddArray();
+            nodes[array].array.reserve(node.size);
+            for (u64 i = 0; i < node.size; i++) {
+                u32 child = ImportNode(node.array[i]);
+                nodes[array].array.push_back(child);
+            }
+            return array;
+        }
+
+        case NodeType::Hash: {
+            u32 hash = AddHash();
+            nodes[hash].hash.reserve(node.size);
+            for (u64 i = 0; i < node.size; i++) { //Keys of a parsed node are already unique
+                u32 key = Intern(keyIndices, keyPool, node.hash[i].key, strlen(node.hash[i].key));
+                u32 child = ImportNode(node.hash[i].node);
+                nodes[hash].hash.emplace_back(key, child);
+            }
+            return hash;
+        }
+
+        case NodeType::Bool:
+            return AddBool(node.Bool);
+
+        case NodeType::Int:
+            return AddInt(node.Int);
+
+        case NodeType::Float:
+            return AddFloat(node.Float);
+
+        case NodeType::UInt:
+            return AddUInt(node.UInt);
+
+        case NodeType::Int64:
+            return AddInt64(node.Int64);
+
+        case NodeType::UInt64:
+            return AddUInt64(node.UInt64);
+
+        case NodeType::Double:
+            return AddDouble(node.Double);
+
+        default:
+            return AddNull();
+    }
+}
+
+bool ByamlWriter::Append(u32 array, u32 value) {
+    if (array >= nodes.size() || value >= nodes.size() || nodes[array].type != NodeType::Array)
+        return false;
+
+    nodes[array].array.push_back(value);
+    layoutDirty = true;
+    return true;
+}
+
+bool ByamlWriter::Set(u32 hash, const char* key, u32 value) {
+    if (hash >= nodes.size() || value >= nodes.size() || key == nullptr || nodes[hash].type != NodeType::Hash)
+        return false;
+
+    //Duplicates are resolved (last one wins) when the file is laid out, so building stays O(1) per entry
+    nodes[hash].hash.emplace_back(Intern(keyIndices, keyPool, key, strlen(key)), value);
+    nodes[hash].keysAdded = true;
+    layoutDirty = true;
+    return true;
+}
+
+bool ByamlWriter::SetRoot(u32 container) {
+    if (container >= nodes.size() || !IsContainer(nodes[container].type))
+        return false;
+
+    this->root = container;
+    layoutDirty = true;
+    return true;
+}
+
+bool ByamlWriter::Check(u32 handle, u32 depth, std::vector<u8>& states, std::vector<bool>& usedKeys, std::vector<bool>& usedStrings) {
+    if (states[handle] == 2) //Already checked through another parent
+        return true;
+
+    ByamlWriterNode& node = nodes[handle];
+    switch (node.type) {
+        case NodeType::String:
+            usedStrings[node.value] = true;
+            break;
+
+        case NodeType::Binary:
+            if (version < 4) {
+                InValidate("Binary nodes need version 4");
+                return false;
+            }
+            break;
+
+        case NodeType::Int64:
+        case NodeType::UInt64:
+        case NodeType::Double:
+            if (version < 3) {
+                InValidate("64-bit nodes need version 3+");
+                return false;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    if (!IsContainer(node.type)) {
+        states[handle] = 2;
+        return true;
+    }
+
+    if (states[handle] == 1 || depth > MaxContainerDepth) {
+        InValidate(states[handle] == 1 ? "Container contains itself" : "Containers nested too deep");
+        return false;
+    }
+    states[handle] = 1;
+
+    if (node.type == NodeType::Hash && node.keysAdded) { //Keep the last value set for each key
+        std::stable_sort(node.hash.begin(), node.hash.end(), [](const std::pair<u32, u32>& a, const std::pair<u32, u32>& b) {
+            return a.first < b.first;
+        });
+        auto last = std::unique(node.hash.rbegin(), node.hash.rend(), [](const std::pair<u32, u32>& a, const std::pair<u32, u32>& b) {
+            return a.first == b.first;
+        });
+        node.hash.erase(node.hash.begin(), last.base());
+        node.keysAdded = false;
+    }
+
+    u64 count = (node.type == NodeType::Array) ? node.array.size() : node.hash.size();
+    if (count > MaxCount) {
+        InValidate("Too many container entries");
+        return false;
+    }
+
+    for (u64 i = 0; i < count; i++) {
+        u32 child = (node.type == NodeType::Array) ? node.array[i] : node.hash[i].second;
+        if (node.type == NodeType::Hash)
+            usedKeys[node.hash[i].first] = true;
+        if (!Check(child, depth + 1, states, usedKeys, usedStrings))
+            return false;
+    }
+
+    states[handle] = 2;
+    return true;
+}
+
+u64 ByamlWriter::BuildTable(const std::vector<bool>& used, const std::vector<std::string>& pool, std::vector<u32>& outTable, std::vector<u32>& outIndices) {
+    outTable.clear();
+    outIndices.assign(pool.size(), 0);
+    for (u32 i = 0; i < pool.size(); i++) {
+        if (used[i])
+            outTable.push_back(i);
+    }
+
+    //Sorted by byte value, so readers can binary search the table (see Byaml::GetKeyIndex)
+    std::sort(outTable.begin(), outTable.end(), [&pool](u32 a, u32 b) {
+        return strcmp(pool[a].c_str(), pool[b].c_str()) < 0;
+    });
+
+    if (outTable.empty())
+        return 0;
+
+    u64 size = 4 + (4 * (outTable.size() + 1));
+    for (u32 i = 0; i < outTable.size(); i++) {
+        outIndices[outTable[i]] = i;
+        size += pool[outTable[i]].size() + 1;
+    }
+    return (size + 3) & ~3ULL;
+}
+
+bool ByamlWriter::IsSameData(u32 a, u32 b) const { //Children must already be shared
+    const ByamlWriterNode& nodeA = nodes[a];
+    const ByamlWriterNode& nodeB = nodes[b];
+    if (nodeA.type != nodeB.type)
+        return false;
+
+    if (nodeA.type == NodeType::Array) {
+        if (nodeA.array.size() != nodeB.array.size())
+            return false;
+
+        for (u32 i = 0; i < nodeA.array.size(); i++) {
+            u32 childA = nodeA.array[i], childB = nodeB.array[i];
+            if (nodes[childA].type != nodes[childB].type || GetValue(childA) != GetValue(childB))
+                return false;
+        }
+        return true;
+    }
+
+    if (nodeA.type == NodeType::Hash) {
+        if (nodeA.hash.size() != nodeB.hash.size())
+            return false;
+
+        for (u32 i = 0; i < nodeA.hash.size(); i++) {
+            u32 childA = nodeA.hash[i].second, childB = nodeB.hash[i].second;
+            if (nodeA.hash[i].first != nodeB.hash[i].first || nodes[childA].type != nodes[childB].type ||
+                GetValue(childA) != GetValue(childB))
+                return false;
+        }
+        return true;
+    }
+
+    return nodeA.value == nodeB.value; //Binaries are interned, so equal data has an equal pool index
+}
+
+void ByamlWriter::Share(u32 handle) {
+    if (sharedNodes[handle] != InvalidHandle)
+        return;
+
+    //Children first, so identical subtrees end up with identical contents
+    ByamlWriterNode& node = nodes[handle];
+    u64 hash = static_cast<u64>(node.type);
+    if (node.type == NodeType::Array) {
+        for (u32 child : node.array) {
+            Share(child);
+            hash = MixHash(hash, (static_cast<u64>(nodes[child].type) << 32) | GetValue(child));
+        }
+    }
+    else if (node.type == NodeType::Hash) {
+        for (const auto& elem : node.hash)
+            Share(elem.second);
+
+        //Parsed and previously written hashes are already in key table order
+        auto byKeyIndex = [this](const std::pair<u32, u32>& a, const std::pair<u32, u32>& b) {
+            return keyTableIndices[a.first] < keyTableIndices[b.first];
+        };
+        if (!std::is_sorted(node.hash.begin(), node.hash.end(), byKeyIndex))
+            std::sort(node.hash.begin(), node.hash.end(), byKeyIndex);
+
+        for (const auto& elem : node.hash) {
+            hash = MixHash(hash, elem.first);
+            hash = MixHash(hash, (static_cast<u64>(nodes[elem.second].type) << 32) | GetValue(elem.second));
+        }
+    }
+    else {
+        hash = MixHash(hash, node.value);
+    }
+
+    sharedNodes[handle] = handle;
+    if (!IsOutOfLine(node.type))
+        return;
+
+    //Open addressing over the handles written so far; collisions fall through to the next slot
+    hash = FinalizeHash(hash);
+    dataHashes[handle] = hash;
+    u32 mask = static_cast<u32>(sharedSlots.size() - 1);
+    for (u32 slot = static_cast<u32>(hash) & mask;; slot = (slot + 1) & mask) {
+        u32 other = sharedSlots[slot];
+        if (other == InvalidHandle) {
+            sharedSlots[slot] = handle;
+            return;
+        }
+
+        if (dataHashes[other] == hash && IsSameData(other, handle)) {
+            sharedNodes[handle] = other;
+            return;
+        }
+    }
+}
+
+u32 ByamlWriter::GetValue(u32 handle) const { //Before layout, out-of-line values are identified by their shared handle
+    const ByamlWriterNode& node = nodes[handle];
+    if (IsOutOfLine(node.type))
+        return layoutDirty ? sharedNodes[handle] : nodeOffsets[sharedNodes[handle]];
+
+    if (node.type == NodeType::String)
+        return stringTableIndices[node.value];
+
+    return static_cast<u32>(node.value);
+}
+
+u32 ByamlWriter::GetDataSize(u32 handle) const {
+    const ByamlWriterNode& node = nodes[handle];
+    switch (node.type) {
+        case NodeType::Array:
+            return 4 + AlignUp(static_cast<u32>(node.array.size()), 4) + (4 * static_cast<u32>(node.array.size()));
+
+        case NodeType::Hash:
+            return 4 + (8 * static_cast<u32>(node.hash.size()));
+
+        case NodeType::Binary:
+            return AlignUp(4 + static_cast<u32>(binaryPool[node.value].size()), 4);
+
+        default: //64-bit values
+            return 8;
+    }
+}
+
+u64 ByamlWriter::Place(u32 handle, u64 offset) { //Depth first, each container followed by its children's data
+    u32 shared = sharedNodes[handle];
+    const ByamlWriterNode& node = nodes[shared];
+    if (!IsOutOfLine(node.type) || nodeOffsets[shared] != 0)
+        return offset;
+
+    nodeOffsets[shared] = static_cast<u32>(offset);
+    layoutOrder.push_back(shared);
+    offset += GetDataSize(shared);
+    if (offset > 0xFFFFFFFF) //Keep going, Layout reports the overflow
+        offset = 0xFFFFFFFFULL + 1;
+
+    if (node.type == NodeType::Array) {
+        for (u32 child : node.array)
+            offset = Place(child, offset);
+    }
+    else if (node.type == NodeType::Hash) {
+        for (const auto& elem : node.hash)
+            offset = Place(elem.second, offset);
+    }
+    return offset;
+}
+
+bool ByamlWriter::Layout() {
+    if (!isValid)
+        return false;
+
+    if (!layoutDirty)
+        return true;
+
+    if (root == InvalidHandle) {
+        InValidate("No root node");
+        return false;
+    }
+
+    std::vector<u8> states(nodes.size(), 0);
+    std::vector<bool> usedKeys(keyPool.size(), false), usedStrings(stringPool.size(), false);
+    if (!Check(root, 0, states, usedKeys, usedStrings))
+        return false;
+
+    //Only what the tree still references goes in the tables, replaced values don't leave orphans
+    u64 keyTableSize = BuildTable(usedKeys, keyPool, keyTable, keyTableIndices);
+    u64 stringTableSize = BuildTable(usedStrings, stringPool, stringTable, stringTableIndices);
+    if (keyTable.size() > MaxCount || stringTable.size() > MaxCount) {
+        InValidate("Too many strings");
+        return false;
+    }
+
+    sharedNodes.assign(nodes.size(), InvalidHandle);
+    u32 slotCount = 0x10;
+    while (slotCount < nodes.size() * 2)
+        slotCount <<= 1;
+    sharedSlots.assign(slotCount, InvalidHandle);
+    dataHashes.resize(nodes.size());
+    Share(root);
+
+    u64 offset = HeaderSize;
+    keyTableOffset = keyTableSize ? static_cast<u32>(offset) : 0;
+    offset += keyTableSize;
+    stringTableOffset = stringTableSize ? static_cast<u32>(offset) : 0;
+    offset += stringTableSize;
+
+    nodeOffsets.assign(nodes.size(), 0);
+    layoutOrder.clear();
+    layoutOrder.reserve(nodes.size());
+    offset = Place(root, offset);
+    if (offset > 0xFFFFFFFF) {
+        InValidate("File too large");
+        return false;
+    }
+
+    this->fileSize = offset;
+    layoutDirty = false;
+    return true;
+}
+
+u64 ByamlWriter::GetSize() {
+    return Layout() ? fileSize : 0;
+}
+
+void ByamlWriter::WriteTable(u8* out, u32 offset, const std::vector<u32>& table, const std::vector<std::string>& pool) const {
+    u8* start = out + offset;
+    start[0] = static_cast<u8>(NodeType::StringTable);
+    WriteU24(start + 1, static_cast<u32>(table.size()));
+
+    u32 pos = 4 + (4 * static_cast<u32>(table.size() + 1));
+    for (u32 i = 0; i < table.size(); i++) {
+        const std::string& str = pool[table[i]];
+        WriteU32(start + 4 + (4*i), pos);
+        memcpy(start + pos, str.c_str(), str.size() + 1);
+        pos += static_cast<u32>(str.size()) + 1;
+    }
+    WriteU32(start + 4 + (4 * table.size()), pos); //End of the last string
+}
+
+void ByamlWriter::WriteNode(u8* out, u32 handle) const {
+    const ByamlWriterNode& node = nodes[handle];
+    u8* start = out + nodeOffsets[handle];
+    switch (node.type) {
+        case NodeType::Array: {
+            u32 count = static_cast<u32>(node.array.size());
+            start[0] = static_cast<u8>(NodeType::Array);
+            WriteU24(start + 1, count);
+
+            u8* values = start + 4 + AlignUp(count, 4);
+            for (u32 i = 0; i < count; i++) {
+                start[4 + i] = static_cast<u8>(nodes[node.array[i]].type);
+                WriteU32(values + (4*i), GetValue(node.array[i]));
+            }
+            break;
+        }
+
+        case NodeType::Hash: {
+            start[0] = static_cast<u8>(NodeType::Hash);
+            WriteU24(start + 1, static_cast<u32>(node.hash.size()));
+
+            u8* entry = start + 4;
+            for (const auto& elem : node.hash) {
+                WriteU24(entry, keyTableIndices[elem.first]);
+                entry[3] = static_cast<u8>(nodes[elem.second].type);
+                WriteU32(entry + 4, GetValue(elem.second));
+                entry += 8;
+            }
+            break;
+        }
+
+        case NodeType::Binary: {
+            const std::string& binary = binaryPool[node.value];
+            WriteU32(start, static_cast<u32>(binary.size()));
+            memcpy(start + 4, binary.data(), binary.size());
+            break;
+        }
+
+        default:
+            WriteU64(start, node.value);
+            break;
+    }
+}
+
+bool ByamlWriter::WriteTo(u8* outBuffer, u64 bufSize) {
+    if (!Layout())
+        return false;
+
+    if (outBuffer == nullptr || bufSize < fileSize) {
+        InValidate("Output buffer too small");
+        return false;
+    }
+
+    memset(outBuffer, 0, fileSize); //Padding
+    memcpy(outBuffer, "YB", 2);
+    WriteU16(outBuffer + 0x2, version);
+    WriteU32(outBuffer + 0x4, keyTableOffset);
+    WriteU32(outBuffer + 0x8, stringTableOffset);
+    WriteU32(outBuffer + 0xC, nodeOffsets[sharedNodes[root]]);
+
+    if (keyTableOffset != 0)
+        WriteTable(outBuffer, keyTableOffset, keyTable, keyPool);
+    if (stringTableOffset != 0)
+        WriteTable(outBuffer, stringTableOffset, stringTable, stringPool);
+
+    for (u32 handle : layoutOrder)
+        WriteNode(outBuffer, handle);
+    return true;
+}
+
+u8* ByamlWriter::Write(u64& outSize) {
+    outSize = 0;
+    if (!Layout())
+        return nullptr;
+
+    u8* out = new u8[fileSize];
+    if (!WriteTo(out, fileSize)) {
+        delete[] out;
+        return nullptr;
+    }
+
+    outSize = fileSize;
+    return out;
+}
+
+bool ByamlWriter::WriteFile(const char* filePath) {
+    if (filePath == nullptr || !Layout())
+        return false;
+
+    std::vector<u8> out(fileSize);
+    if (!WriteTo(out.data(), out.size()))
+        return false;
+
+    FILE* file = fopen(filePath, "wb");
+    if (file == NULL) {
+        InValidate("Failed to open file");
+        return false;
+    }
+
+    bool ok = fwrite(out.data(), sizeof(u8), out.size(), file) == out.size();
+    if (fclose(file) != 0)
+        ok = false;
+
+    if (!ok)
+        InValidate("Failed to write file");
+    return ok;
+}
@@ -0,0 +1,1125 @@
+/**
+ *
+ * ByamlYaml.cpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#include "ByamlYaml.hpp"
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <charconv>
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <io.h>
+#define LIBACNH_WRITE_FD _write
+#else
+#include <unistd.h>
+#define LIBACNH_WRITE_FD write
+#endif
+
+static const constexpr u32 MaxContainerDepth = 0x100; //Same limit as the parser
+static const constexpr u32 InvalidHandle = static_cast<u32>(-1);
+static const constexpr u32 IndentWidth = 2;
+static const constexpr u64 ReadChunkSize = 0x10000;
+static const char Base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static s32 HexValue(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static bool Equals(const char* text, u64 size, const char* literal) {
+    return strlen(literal) == size && memcmp(text, literal, size) == 0;
+}
+
+static bool EqualsNoCase(const char* text, u64 size, const char* literal) { //literal is lowercase
+    if (strlen(literal) != size)
+        return false;
+
+    for (u64 i = 0; i < size; i++) {
+        char c = (text[i] >= 'A' && text[i] <= 'Z') ? text[i] - 'A' + 'a' : text[i];
+        if (c != literal[i])
+            return false;
+    }
+    return true;
+}
+
+//[+-]?(0x[0-9a-fA-F]+|[0-9]+), false if it isn't one or doesn't fit in 64 bits
+static bool ParseInteger(const char* text, u64 size, bool& outNegative, u64& outMagnitude) {
+    const char* p = text;
+    const char* end = text + size;
+    outNegative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+        outNegative = *p++ == '-';
+
+    u32 base = 10;
+    if ((end - p) > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        base = 16;
+        p += 2;
+    }
+
+    if (p == end)
+        return false;
+
+    u64 value = 0;
+    for (; p != end; p++) {
+        s32 digit = (base == 16) ? HexValue(*p) : (IsDigit(*p) ? *p - '0' : -1);
+        if (digit < 0 || value > (static_cast<u64>(-1) - digit) / base)
+            return false;
+        value = (value * base) + digit;
+    }
+
+    outMagnitude = value;
+    return true;
+}
+
+//YAML 1.2 core schema floats: [-+]?(\.[0-9]+|[0-9]+(\.[0-9]*)?)([eE][-+]?[0-9]+)? plus .inf and .nan
+static bool IsFloat(const char* text, u64 size) {
+    const char* p = text;
+    const char* end = text + size;
+    if (p != end && (*p == '-' || *p == '+'))
+        p++;
+
+    if (Equals(p, end - p, ".inf") || Equals(p, end - p, ".Inf") || Equals(p, end - p, ".INF"))
+        return true;
+    if (p == text && (Equals(p, end - p, ".nan") || Equals(p, end - p, ".NaN") || Equals(p, end - p, ".NAN")))
+        return true;
+
+    bool hasDigits = false, hasDot = false, hasExponent = false;
+    for (; p != end && IsDigit(*p); p++)
+        hasDigits = true;
+
+    if (p != end && *p == '.') {
+        hasDot = true;
+        for (p++; p != end && IsDigit(*p); p++)
+            hasDigits = true;
+    }
+
+    if (hasDigits && p != end && (*p == 'e' || *p == 'E')) {
+        hasExponent = true;
+        p++;
+        if (p != end && (*p == '-' || *p == '+'))
+            p++;
+        if (p == end || !IsDigit(*p))
+            return false;
+        for (; p != end && IsDigit(*p); p++);
+    }
+    return hasDigits && (hasDot || hasExponent) && p == end;
+}
+
+static double ParseFloatText(const char* text, u64 size) {
+    const char* p = text;
+    bool negative = (size != 0 && *p == '-');
+    if (size != 0 && (*p == '-' || *p == '+'))
+        p++;
+
+    if (*p == '.' && (p[1] == 'i' || p[1] == 'I'))
+        return negative ? -INFINITY : INFINITY;
+    if (*p == '.' && (p[1] == 'n' || p[1] == 'N'))
+        return NAN;
+
+    std::string str(text, size); //strtod needs a terminator
+    return strtod(str.c_str(), nullptr);
+}
+
+//What a plain (unquoted, untagged) scalar reads back as: Null, Bool, Int (any integer), Float or String
+static NodeType ResolvePlain(const char* text, u64 size) {
+    if (size == 0 || Equals(text, size, "~") || Equals(text, size, "null") || Equals(text, size, "Null") || Equals(text, size, "NULL"))
+        return NodeType::Null;
+
+    if (Equals(text, size, "true") || Equals(text, size, "True") || Equals(text, size, "TRUE") ||
+        Equals(text, size, "false") || Equals(text, size, "False") || Equals(text, size, "FALSE"))
+        return NodeType::Bool;
+
+    if (IsDigit(text[0]) || text[0] == '-' || text[0] == '+' || text[0] == '.') {
+        bool negative;
+        u64 magnitude;
+        if (ParseInteger(text, size, negative, magnitude))
+            return NodeType::Int;
+        if (IsFloat(text, size))
+            return NodeType::Float;
+    }
+    return NodeType::String;
+}
+
+//Whether another reader could resolve a plain scalar as something other than a string. Wider than ResolvePlain:
+//YAML 1.1 bools (yes/no/on/off/y/n) and ints/floats (0b, 0o, legacy octal, '_' separators, sexagesimal 1:30),
+//any capitalisation of those and of the 1.2 core forms, and bare nan/inf. Matches are quoted when emitting
+static bool MayRetype(const char* text, u64 size) {
+    static const char* const Words[] = { "~", "null", "true", "false", "yes", "no", "y", "n", "on", "off" };
+    for (const char* word : Words) {
+        if (EqualsNoCase(text, size, word))
+            return true;
+    }
+
+    const char* p = text;
+    const char* end = text + size;
+    if (p != end && (*p == '-' || *p == '+'))
+        p++;
+    if (p != end && *p == '.' && (EqualsNoCase(p + 1, end - p - 1, "inf") || EqualsNoCase(p + 1, end - p - 1, "nan")))
+        return true;
+    if (EqualsNoCase(p, end - p, "inf") || EqualsNoCase(p, end - p, "nan") || EqualsNoCase(p, end - p, "infinity"))
+        return true;
+
+    if ((end - p) > 2 && p[0] == '0' && strchr("xXoObB", p[1]) != nullptr) { //0x/0o/0b, the digits are checked loosely
+        for (p += 2; p != end && (HexValue(*p) >= 0 || *p == '_'); p++);
+        return p == end;
+    }
+
+    //Digits, '_' and ':' (sexagesimal), one '.', then an optional exponent
+    bool hasDigits = false;
+    for (; p != end && (IsDigit(*p) || *p == '_' || *p == ':'); p++)
+        hasDigits |= IsDigit(*p);
+    if (p != end && *p == '.') {
+        for (p++; p != end && (IsDigit(*p) || *p == '_'); p++)
+            hasDigits |= IsDigit(*p);
+    }
+    if (hasDigits && p != end && (*p == 'e' || *p == 'E')) {
+        p++;
+        if (p != end && (*p == '-' || *p == '+'))
+            p++;
+        if (p == end || !IsDigit(*p))
+            return false;
+        for (; p != end && IsDigit(*p); p++);
+    }
+    return hasDigits && p == end;
+}
+
+/* ----- ByamlYamlEmitter ----- */
+
+ByamlYamlEmitter::ByamlYamlEmitter(const ByamlYamlSink& sink, u32 bufferSize) : sink(sink), buffer(bufferSize < 0x100 ? 0x100 : bufferSize) {
+    if (!sink)
+        InValidate("Invalid sink");
+}
+
+bool ByamlYamlEmitter::IsValid() const {
+    return isValid;
+}
+
+const char* ByamlYamlEmitter::GetErrorMessage() const {
+    return errorMessage;
+}
+
+ByamlYamlSink ByamlYamlEmitter::FileSink(FILE* file) {
+    return [file](const char* data, u64 size) {
+        return file != NULL && fwrite(data, sizeof(char), size, file) == size;
+    };
+}
+
+ByamlYamlSink ByamlYamlEmitter::FdSink(int fd) {
+    return [fd](const char* data, u64 size) {
+        while (size != 0) { //Pipes and sockets can take less than asked
+            auto written = LIBACNH_WRITE_FD(fd, data, static_cast<unsigned int>(size < 0x40000000 ? size : 0x40000000));
+            if (written <= 0)
+                return false;
+            data += written;
+            size -= written;
+        }
+        return true;
+    };
+}
+
+ByamlYamlSink ByamlYamlEmitter::StringSink(std::string& outStr) {
+    return [&outStr](const char* data, u64 size) {
+        outStr.append(data, size);
+        return true;
+    };
+}
+
+bool ByamlYamlEmitter::Flush() {
+    if (bufferPos != 0 && isValid && !sink(buffer.data(), bufferPos))
+        InValidate("Failed to write output");
+
+    bufferPos = 0;
+    return isValid;
+}
+
+void ByamlYamlEmitter::Write(const char* data, u64 size) {
+    while (size != 0 && isValid) {
+        if (bufferPos == buffer.size())
+            Flush();
+
+        u64 copySize = std::min<u64>(size, buffer.size() - bufferPos);
+        memcpy(buffer.data() + bufferPos, data, copySize);
+        bufferPos += copySize;
+        data += copySize;
+        size -= copySize;
+    }
+}
+
+void ByamlYamlEmitter::WriteChar(char c) {
+    if (bufferPos == buffer.size())
+        Flush();
+    buffer[bufferPos++] = c;
+}
+
+void ByamlYamlEmitter::WriteIndent(u32 indent) {
+    static const char Spaces[] = "                                ";
+    for (; indent > sizeof(Spaces) - 1; indent -= sizeof(Spaces) - 1)
+        Write(Spaces, sizeof(Spaces) - 1);
+    Write(Spaces, indent);
+}
+
+void ByamlYamlEmitter::WriteString(const char* str, u64 size) {
+    bool quote = size == 0 || MayRetype(str, size) || strchr("-?:,[]{}#&*!|>'\"%@` ", str[0]) != nullptr ||
+        str[size - 1] == ' ' || str[size - 1] == ':';
+    for (u64 i = 0; !quote && i < size; i++) {
+        u8 c = static_cast<u8>(str[i]);
+        quote = c < 0x20 || c == 0x7F || c == ',' || c == '[' || c == ']' || c == '{' || c == '}' ||
+            (c == ':' && str[i + 1] == ' ') || (c == '#' && str[i - 1] == ' ');
+    }
+
+    if (!quote) {
+        Write(str, size);
+        return;
+    }
+
+    WriteChar('"');
+    const char* run = str; //Characters that don't need escaping are copied in runs
+    for (u64 i = 0; i < size; i++) {
+        u8 c = static_cast<u8>(str[i]);
+        if (c >= 0x20 && c != 0x7F && c != '"' && c != '\\')
+            continue;
+
+        Write(run, (str + i) - run);
+        run = str + i + 1;
+        switch (c) {
+            case '"':
+                Write("\\\"", 2);
+                break;
+            case '\\':
+                Write("\\\\", 2);
+                break;
+            case '\n':
+                Write("\\n", 2);
+                break;
+            case '\t':
+                Write("\\t", 2);
+                break;
+            case '\r':
+                Write("\\r", 2);
+                break;
+            default: {
+                const char escape[4] = { '\\', 'x', "0123456789ABCDEF"[c >> 4], "0123456789ABCDEF"[c & 0xF] };
+                Write(escape, 4);
+                break;
+            }
+        }
+    }
+    Write(run, (str + size) - run);
+    WriteChar('"');
+}
+
+void ByamlYamlEmitter::WriteBase64(const u8* data, u32 size) {
+    char quad[4];
+    for (u32 i = 0; i < size; i += 3) {
+        u32 remaining = size - i;
+        u32 bits = (data[i] << 16) | ((remaining > 1 ? data[i + 1] : 0) << 8) | (remaining > 2 ? data[i + 2] : 0);
+        quad[0] = Base64Chars[(bits >> 18) & 0x3F];
+        quad[1] = Base64Chars[(bits >> 12) & 0x3F];
+        quad[2] = remaining > 1 ? Base64Chars[(bits >> 6) & 0x3F] : '=';
+        quad[3] = remaining > 2 ? Base64Chars[bits & 0x3F] : '=';
+        Write(quad, 4);
+    }
+}
+
+template <typename T>
+static u32 FormatFloat(char* out, u32 size, T value) { //Shortest text that reads back as the same value
+    if (std::isnan(value)) { //YAML has one NaN, so the sign and payload bits are dropped
+        memcpy(out, ".nan", 4);
+        return 4;
+    }
+    if (std::isinf(value)) {
+        memcpy(out, value < 0 ? "-.inf" : ".inf", value < 0 ? 5 : 4);
+        return value < 0 ? 5 : 4;
+    }
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    u32 length = static_cast<u32>(std::to_chars(out, out + size - 2, value).ptr - out);
+#else
+    u32 length = 0;
+    for (int precision = (sizeof(T) == 4) ? 6 : 15; precision <= ((sizeof(T) == 4) ? 9 : 17); precision++) {
+        length = snprintf(out, size - 2, "%.*g", precision, static_cast<double>(value));
+        if (static_cast<T>(strtod(out, nullptr)) == value)
+            break;
+    }
+#endif
+
+    if (memchr(out, '.', length) == nullptr && memchr(out, 'e', length) == nullptr) { //Would read back as an integer
+        out[length++] = '.';
+        out[length++] = '0';
+    }
+    return length;
+}
+
+void ByamlYamlEmitter::WriteScalar(const ByamlView& view) {
+    char text[0x40];
+    u32 length = 0;
+    switch (view.GetType()) {
+        case NodeType::String: {
+            const char* str = nullptr;
+            if (!view.GetString(str)) {
+                InValidate("Invalid string");
+                return;
+            }
+            WriteString(str, strlen(str));
+            return;
+        }
+
+        case NodeType::Binary: {
+            const u8* data = nullptr;
+            u32 size = 0;
+            if (!view.GetBinary(data, size)) {
+                InValidate("Invalid binary");
+                return;
+            }
+            Write("!!binary ", 9);
+            if (size == 0)
+                Write("\"\"", 2);
+            WriteBase64(data, size);
+            return;
+        }
+
+        case NodeType::Array:
+            Write("[]", 2); //Only empty containers are written inline
+            return;
+
+        case NodeType::Hash:
+            Write("{}", 2);
+            return;
+
+        case NodeType::Bool: {
+            bool value = false;
+            view.GetBool(value);
+            if (value)
+                Write("true", 4);
+            else
+                Write("false", 5);
+            return;
+        }
+
+        case NodeType::Int: {
+            s32 value = 0;
+            view.GetInt(value);
+            length = static_cast<u32>(std::to_chars(text, text + sizeof(text), value).ptr - text);
+            break;
+        }
+
+        case NodeType::Float: {
+            float value = 0;
+            view.GetFloat(value);
+            length = FormatFloat(text, sizeof(text), value);
+            break;
+        }
+
+        case NodeType::UInt: {
+            u32 value = 0;
+            view.GetUInt(value);
+            memcpy(text, "!u 0x", 5);
+            length = static_cast<u32>(std::to_chars(text + 5, text + sizeof(text), value, 16).ptr - text);
+            break;
+        }
+
+        case NodeType::Int64: {
+            s64 value = 0;
+            if (!view.GetInt64(value)) {
+                InValidate("Invalid 64-bit value");
+                return;
+            }
+            memcpy(text, "!l ", 3);
+            length = static_cast<u32>(std::to_chars(text + 3, text + sizeof(text), value).ptr - text);
+            break;
+        }
+
+        case NodeType::UInt64: {
+            u64 value = 0;
+            if (!view.GetUInt64(value)) {
+                InValidate("Invalid 64-bit value");
+                return;
+            }
+            memcpy(text, "!ul 0x", 6);
+            length = static_cast<u32>(std::to_chars(text + 6, text + sizeof(text), value, 16).ptr - text);
+            break;
+        }
+
+        case NodeType::Double: {
+            double value = 0;
+            if (!view.GetDouble(value)) {
+                InValidate("Invalid 64-bit value");
+                return;
+            }
+            memcpy(text, "!f64 ", 5);
+            length = 5 + FormatFloat(text + 5, sizeof(text) - 5, value);
+            break;
+        }
+
+        case NodeType::Null:
+            Write("null", 4);
+            return;
+
+        default:
+            InValidate("Invalid node type");
+            return;
+    }
+    Write(text, length);
+}
+
+void ByamlYamlEmitter::WriteEntryValue(const ByamlView& view, u32 indent, bool afterDash, u32 depth) {
+    if ((view.IsArray() || view.IsHash()) && view.GetSize() != 0) {
+        if (afterDash) { //"- " then the first entry on the same line
+            WriteChar(' ');
+            WriteContainer(view, indent, true, depth + 1);
+        }
+        else {
+            WriteChar('\n');
+            WriteContainer(view, indent, false, depth + 1);
+        }
+        return;
+    }
+
+    WriteChar(' ');
+    WriteScalar(view);
+    WriteChar('\n');
+}
+
+void ByamlYamlEmitter::WriteContainer(const ByamlView& view, u32 indent, bool continueLine, u32 depth) {
+    if (depth > MaxContainerDepth) {
+        InValidate("Containers nested too deep");
+        return;
+    }
+
+    bool isArray = view.IsArray();
+    u32 count = view.GetSize();
+    for (u32 i = 0; i < count && isValid; i++) {
+        if (i != 0 || !continueLine)
+            WriteIndent(indent);
+
+        ByamlView child = view.At(i);
+        if (!child.IsValid()) {
+            InValidate("Invalid node");
+            return;
+        }
+
+        if (isArray) {
+            WriteChar('-');
+        }
+        else {
+            const char* key = view.GetKey(i);
+            if (key == nullptr) {
+                InValidate("Invalid hash key");
+                return;
+            }
+            WriteString(key, strlen(key));
+            WriteChar(':');
+        }
+        WriteEntryValue(child, indent + IndentWidth, isArray, depth);
+    }
+}
+
+bool ByamlYamlEmitter::Emit(const ByamlView& root) {
+    if (!isValid)
+        return false;
+
+    if (!root.IsArray() && !root.IsHash()) {
+        InValidate("Root must be a container");
+        return false;
+    }
+
+    if (root.GetSize() == 0) {
+        WriteScalar(root);
+        WriteChar('\n');
+    }
+    else {
+        WriteContainer(root, 0, false, 0);
+    }
+    return Flush();
+}
+
+/* ----- ByamlYamlParser ----- */
+
+static const char* SkipSpaces(const char* p, const char* end) {
+    while (p != end && *p == ' ')
+        p++;
+    return p;
+}
+
+static bool IsDash(const char* p, const char* end) { //Sequence entry indicator
+    return p != end && *p == '-' && (p + 1 == end || p[1] == ' ');
+}
+
+static bool IsLineEnd(const char* p, const char* end) { //Nothing left but a comment
+    p = SkipSpaces(p, end);
+    return p == end || *p == '#';
+}
+
+//Whether the line is "key: ..." rather than a lone value
+static bool IsMappingEntry(const char* p, const char* end) {
+    if (p == end || *p == '[' || *p == '{')
+        return false;
+
+    if (*p == '"' || *p == '\'') {
+        char quote = *p++;
+        for (; p != end; p++) {
+            if (*p == '\\' && quote == '"' && p + 1 != end) {
+                p++;
+            }
+            else if (*p == quote) {
+                if (quote == '\'' && p + 1 != end && p[1] == '\'') {
+                    p++;
+                    continue;
+                }
+                break;
+            }
+        }
+        if (p == end)
+            return false;
+        p = SkipSpaces(p + 1, end);
+        return p != end && *p == ':' && (p + 1 == end || p[1] == ' ');
+    }
+
+    for (; p != end; p++) {
+        if (*p == ':' && (p + 1 == end || p[1] == ' '))
+            return true;
+        if (*p == '#' && p[-1] == ' ')
+            return false;
+    }
+    return false;
+}
+
+ByamlYamlParser::ByamlYamlParser(u16 version) : writer(version) {
+    if (!writer.IsValid())
+        InValidate(writer.GetErrorMessage());
+}
+
+bool ByamlYamlParser::IsValid() const {
+    return isValid;
+}
+
+const char* ByamlYamlParser::GetErrorMessage() const {
+    return errorMessage;
+}
+
+u32 ByamlYamlParser::GetErrorLine() const {
+    return isValid ? 0 : lineNumber;
+}
+
+ByamlWriter& ByamlYamlParser::GetWriter() {
+    return writer;
+}
+
+bool ByamlYamlParser::Attach(u32 parent, bool parentIsArray, const std::string& key, u32 value) {
+    if (value == InvalidHandle)
+        return false;
+
+    if (parentIsArray ? writer.Append(parent, value) : writer.Set(parent, key.c_str(), value))
+        return true;
+
+    InValidate("Failed to add node");
+    return false;
+}
+
+bool ByamlYamlParser::ParseQuoted(const char*& p, const char* end, std::string& outStr) {
+    char quote = *p++;
+    outStr.clear();
+    while (p != end) {
+        char c = *p++;
+        if (c == quote) {
+            if (quote == '\'' && p != end && *p == '\'') { //'' is an escaped quote
+                outStr += '\'';
+                p++;
+                continue;
+            }
+            return true;
+        }
+
+        if (c != '\\' || quote == '\'') {
+            outStr += c;
+            continue;
+        }
+
+        if (p == end)
+            break;
+
+        u32 digits = 0;
+        switch (c = *p++) {
+            case '0': outStr += '\0'; break;
+            case 'a': outStr += '\a'; break;
+            case 'b': outStr += '\b'; break;
+            case 't': outStr += '\t'; break;
+            case 'n': outStr += '\n'; break;
+            case 'v': outStr += '\v'; break;
+            case 'f': outStr += '\f'; break;
+            case 'r': outStr += '\r'; break;
+            case 'e': outStr += '\x1B'; break;
+            case ' ': outStr += ' '; break;
+            case '"': outStr += '"'; break;
+            case '/': outStr += '/'; break;
+            case '\\': outStr += '\\'; break;
+            case 'x': digits = 2; break;
+            case 'u': digits = 4; break;
+            case 'U': digits = 8; break;
+            default:
+                InValidate("Invalid escape sequence");
+                return false;
+        }
+
+        if (digits == 0)
+            continue;
+
+        u32 codePoint = 0;
+        for (u32 i = 0; i < digits; i++, p++) {
+            s32 value = (p != end) ? HexValue(*p) : -1;
+            if (value < 0) {
+                InValidate("Invalid escape sequence");
+                return false;
+            }
+            codePoint = (codePoint << 4) | value;
+        }
+
+        if (codePoint < 0x80) { //UTF-8
+            outStr += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800) {
+            outStr += static_cast<char>(0xC0 | (codePoint >> 6));
+            outStr += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000) {
+            outStr += static_cast<char>(0xE0 | (codePoint >> 12));
+            outStr += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            outStr += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x110000) {
+            outStr += static_cast<char>(0xF0 | (codePoint >> 18));
+            outStr += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            outStr += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            outStr += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else {
+            InValidate("Invalid escape sequence");
+            return false;
+        }
+    }
+
+    InValidate("Unterminated string"); //Quoted strings can't span lines here
+    return false;
+}
+
+bool ByamlYamlParser::ParseKey(const char*& p, const char* end, bool inFlow, std::string& outKey) {
+    if (p != end && (*p == '"' || *p == '\'')) {
+        if (!ParseQuoted(p, end, outKey))
+            return false;
+        p = SkipSpaces(p, end);
+    }
+    else {
+        const char* start = p;
+        while (p != end && !(*p == ':' && (p + 1 == end || p[1] == ' ' || (inFlow && (p[1] == ',' || p[1] == '}')))))
+            p++;
+
+        const char* keyEnd = p;
+        while (keyEnd != start && keyEnd[-1] == ' ')
+            keyEnd--;
+        outKey.assign(start, keyEnd);
+    }
+
+    if (p == end || *p != ':') {
+        InValidate("Expected ':' after a key");
+        return false;
+    }
+    p = SkipSpaces(p + 1, end);
+    return true;
+}
+
+u32 ByamlYamlParser::ParsePlain(const char* text, u64 size) {
+    switch (ResolvePlain(text, size)) {
+        case NodeType::Null:
+            return writer.AddNull();
+
+        case NodeType::Bool:
+            return writer.AddBool(text[0] == 't' || text[0] == 'T');
+
+        case NodeType::Int: { //Smallest type that holds it, as only UInt/UInt64 are tagged
+            bool negative;
+            u64 magnitude;
+            ParseInteger(text, size, negative, magnitude);
+            if (!negative && magnitude <= 0x7FFFFFFF)
+                return writer.AddInt(static_cast<s32>(magnitude));
+            if (negative && magnitude <= 0x80000000ULL)
+                return writer.AddInt(static_cast<s32>(0 - magnitude));
+            if (!negative && magnitude <= 0xFFFFFFFFULL)
+                return writer.AddUInt(static_cast<u32>(magnitude));
+            if (!negative && magnitude <= 0x7FFFFFFFFFFFFFFFULL)
+                return writer.AddInt64(static_cast<s64>(magnitude));
+            if (negative && magnitude <= 0x8000000000000000ULL)
+                return writer.AddInt64(static_cast<s64>(0 - magnitude));
+            return writer.AddUInt64(magnitude);
+        }
+
+        case NodeType::Float:
+            return writer.AddFloat(static_cast<float>(ParseFloatText(text, size)));
+
+        default:
+            break;
+    }
+
+    if (text[0] == '&' || text[0] == '*') {
+        InValidate("Anchors and aliases are not supported");
+        return InvalidHandle;
+    }
+
+    if (text[0] == '|' || text[0] == '>') {
+        InValidate("Block scalars are not supported");
+        return InvalidHandle;
+    }
+    return writer.AddString(std::string(text, size).c_str());
+}
+
+u32 ByamlYamlParser::ParseTagged(const std::string& tag, const std::string& text, bool quoted) {
+    bool negative = false;
+    u64 magnitude = 0;
+    bool isInteger = !quoted && ParseInteger(text.c_str(), text.size(), negative, magnitude);
+
+    if (tag == "!u" && isInteger && !negative && magnitude <= 0xFFFFFFFFULL)
+        return writer.AddUInt(static_cast<u32>(magnitude));
+
+    if (tag == "!l" && isInteger && magnitude <= (negative ? 0x8000000000000000ULL : 0x7FFFFFFFFFFFFFFFULL))
+        return writer.AddInt64(static_cast<s64>(negative ? 0 - magnitude : magnitude));
+
+    if (tag == "!ul" && isInteger && !negative)
+        return writer.AddUInt64(magnitude);
+
+    if (tag == "!f64" && !quoted && (isInteger || IsFloat(text.c_str(), text.size())))
+        return writer.AddDouble(ParseFloatText(text.c_str(), text.size()));
+
+    if (tag == "!!str")
+        return writer.AddString(text.c_str());
+
+    if (tag == "!!binary") {
+        std::vector<u8> data;
+        data.reserve((text.size() / 4) * 3);
+        u32 bits = 0, bitCount = 0;
+        for (char c : text) {
+            const char* pos = (c != '\0') ? strchr(Base64Chars, c) : nullptr;
+            if (c == '=' || c == ' ')
+                continue;
+            if (pos == nullptr) {
+                InValidate("Invalid base64");
+                return InvalidHandle;
+            }
+
+            bits = (bits << 6) | static_cast<u32>(pos - Base64Chars);
+            bitCount += 6;
+            if (bitCount >= 8) {
+                bitCount -= 8;
+                data.push_back(static_cast<u8>(bits >> bitCount));
+            }
+        }
+        return writer.AddBinary(data.data(), static_cast<u32>(data.size()));
+    }
+
+    InValidate("Unknown tag or invalid tagged value");
+    return InvalidHandle;
+}
+
+u32 ByamlYamlParser::ParseValue(const char*& p, const char* end, bool inFlow, u32 depth) {
+    p = SkipSpaces(p, end);
+    if (depth > MaxContainerDepth) {
+        InValidate("Containers nested too deep");
+        return InvalidHandle;
+    }
+
+    if (p != end && (*p == '[' || *p == '{')) { //Flow collection, on a single line
+        bool isArray = *p++ == '[';
+        char close = isArray ? ']' : '}';
+        u32 container = isArray ? writer.AddArray() : writer.AddHash();
+        std::string key;
+        for (p = SkipSpaces(p, end); p != end && *p != close;) {
+            if (!isArray && !ParseKey(p, end, true, key))
+                return InvalidHandle;
+
+            u32 value = ParseValue(p, end, true, depth + 1);
+            if (!Attach(container, isArray, key, value))
+                return InvalidHandle;
+
+            p = SkipSpaces(p, end);
+            if (p != end && *p == ',')
+                p = SkipSpaces(p + 1, end);
+            else if (p == end || *p != close)
+                break;
+        }
+
+        if (p == end) {
+            InValidate("Unterminated flow collection");
+            return InvalidHandle;
+        }
+        p++;
+        return container;
+    }
+
+    std::string tag;
+    if (p != end && *p == '!') {
+        const char* start = p;
+        while (p != end && *p != ' ')
+            p++;
+        tag.assign(start, p);
+        p = SkipSpaces(p, end);
+    }
+
+    if (p != end && (*p == '"' || *p == '\'')) {
+        std::string str;
+        if (!ParseQuoted(p, end, str))
+            return InvalidHandle;
+        return tag.empty() ? writer.AddString(str.c_str()) : ParseTagged(tag, str, true);
+    }
+
+    //Plain scalar: up to a comment, and in flow collections up to the next ',' ']' or '}'
+    const char* start = p;
+    while (p != end && !(*p == '#' && p != start && p[-1] == ' ') && !(inFlow && (*p == ',' || *p == ']' || *p == '}')))
+        p++;
+
+    const char* textEnd = p;
+    while (textEnd != start && textEnd[-1] == ' ')
+        textEnd--;
+
+    for (const char* c = start; c != textEnd; c++) {
+        if (*c == ':' && (c + 1 == textEnd || c[1] == ' ')) {
+            InValidate("Unexpected ':' in a plain value");
+            return InvalidHandle;
+        }
+    }
+
+    if (!tag.empty())
+        return ParseTagged(tag, std::string(start, textEnd), false);
+    return ParsePlain(start, textEnd - start);
+}
+
+bool ByamlYamlParser::ParseEntry(u32 indent, const char* p, const char* end) {
+    Frame frame = stack.back();
+    if (frame.isArray) {
+        if (!IsDash(p, end)) {
+            InValidate("Expected '- ' in a sequence");
+            return false;
+        }
+
+        const char* rest = SkipSpaces(p + 1, end);
+        u32 column = indent + static_cast<u32>(rest - p);
+        if (IsLineEnd(rest, end)) { //Value is on the next lines
+            hasPending = true;
+            pendingParent = frame.handle;
+            pendingParentIsArray = true;
+            pendingIndent = indent;
+            return true;
+        }
+
+        if (IsDash(rest, end) || IsMappingEntry(rest, end)) { //"- - x" or "- key: x", a nested container starts on this line
+            bool isArray = IsDash(rest, end);
+            u32 container = isArray ? writer.AddArray() : writer.AddHash();
+            if (!Attach(frame.handle, true, std::string(), container))
+                return false;
+
+            if (stack.size() > MaxContainerDepth) {
+                InValidate("Containers nested too deep");
+                return false;
+            }
+            stack.push_back({ container, column, isArray });
+            return ParseEntry(column, rest, end);
+        }
+
+        u32 value = ParseValue(rest, end, false, static_cast<u32>(stack.size()));
+        if (!Attach(frame.handle, true, std::string(), value))
+            return false;
+        p = rest;
+    }
+    else {
+        if (IsDash(p, end)) {
+            InValidate("Expected a key in a mapping");
+            return false;
+        }
+
+        std::string key;
+        if (!ParseKey(p, end, false, key))
+            return false;
+
+        if (IsLineEnd(p, end)) {
+            hasPending = true;
+            pendingParent = frame.handle;
+            pendingParentIsArray = false;
+            pendingIndent = indent;
+            pendingKey = key;
+            return true;
+        }
+
+        u32 value = ParseValue(p, end, false, static_cast<u32>(stack.size()));
+        if (!Attach(frame.handle, false, key, value))
+            return false;
+    }
+
+    if (!IsLineEnd(p, end)) {
+        InValidate("Unexpected text after a value");
+        return false;
+    }
+    return true;
+}
+
+bool ByamlYamlParser::ParseLine(const char* line, const char* end) {
+    lineNumber++;
+    if (end != line && end[-1] == '\r')
+        end--;
+    if (lineNumber == 1 && (end - line) >= 3 && memcmp(line, "\xEF\xBB\xBF", 3) == 0) //UTF-8 BOM
+        line += 3;
+
+    const char* p = SkipSpaces(line, end);
+    if (p != end && *p == '\t') {
+        InValidate("Tabs can't be used for indentation");
+        return false;
+    }
+
+    if (IsLineEnd(p, end) || isFinished)
+        return true;
+
+    u32 indent = static_cast<u32>(p - line);
+    if (indent == 0 && (end - p) >= 3 && (memcmp(p, "---", 3) == 0 || memcmp(p, "...", 3) == 0) && IsLineEnd(p + 3, end)) {
+        isFinished = (*p == '.') || hasRoot; //Only one document
+        return true;
+    }
+
+    if (!hasRoot) {
+        hasRoot = true;
+        if (*p == '[' || *p == '{') { //Whole document is a flow collection
+            u32 root = ParseValue(p, end, false, 0);
+            if (root == InvalidHandle)
+                return false;
+            if (!IsLineEnd(p, end)) {
+                InValidate("Unexpected text after a value");
+                return false;
+            }
+            isFinished = true;
+            return writer.SetRoot(root);
+        }
+
+        bool isArray = IsDash(p, end);
+        u32 root = isArray ? writer.AddArray() : writer.AddHash();
+        writer.SetRoot(root);
+        stack.push_back({ root, indent, isArray });
+    }
+
+    if (hasPending) { //Deeper lines (or a sequence under a key, at the key's indent) hold the pending value
+        hasPending = false;
+        bool isArray = IsDash(p, end);
+        if (indent > pendingIndent || (indent == pendingIndent && isArray && !pendingParentIsArray)) {
+            u32 container = isArray ? writer.AddArray() : writer.AddHash();
+            if (!Attach(pendingParent, pendingParentIsArray, pendingKey, container))
+                return false;
+
+            if (stack.size() > MaxContainerDepth) {
+                InValidate("Containers nested too deep");
+                return false;
+            }
+            stack.push_back({ container, indent, isArray });
+        }
+        else if (!Attach(pendingParent, pendingParentIsArray, pendingKey, writer.AddNull())) {
+            return false;
+        }
+    }
+
+    //A sequence can sit at its key's indent, so it also ends at the next line there that isn't an entry
+    bool isEntry = IsDash(p, end);
+    while (!stack.empty() && (stack.back().indent > indent || (stack.back().indent == indent && stack.back().isArray && !isEntry && stack.size() > 1)))
+        stack.pop_back();
+
+    if (stack.empty() || stack.back().indent != indent) {
+        InValidate(stack.empty() ? "Text after the root node" : "Bad indentation");
+        return false;
+    }
+    return ParseEntry(indent, p, end);
+}
+
+bool ByamlYamlParser::Parse(const ByamlYamlSource& source) {
+    if (!isValid)
+        return false;
+
+    std::vector<char> chunk(ReadChunkSize);
+    std::string carry; //Start of a line that continues in the next chunk
+    for (u64 size = source(chunk.data(), chunk.size()); size != 0 && isValid; size = source(chunk.data(), chunk.size())) {
+        const char* p = chunk.data();
+        const char* end = p + size;
+        for (const char* newline; isValid && (newline = static_cast<const char*>(memchr(p, '\n', end - p))) != nullptr; p = newline + 1) {
+            if (carry.empty()) {
+                ParseLine(p, newline);
+            }
+            else {
+                carry.append(p, newline);
+                ParseLine(carry.data(), carry.data() + carry.size());
+                carry.clear();
+            }
+        }
+        carry.append(p, end);
+    }
+
+    if (isValid && !carry.empty())
+        ParseLine(carry.data(), carry.data() + carry.size());
+
+    if (isValid && hasPending) {
+        hasPending = false;
+        Attach(pendingParent, pendingParentIsArray, pendingKey, writer.AddNull());
+    }
+
+    if (isValid && !hasRoot)
+        InValidate("Empty document");
+    return isValid;
+}
+
+bool ByamlYamlParser::ParseFile(const char* filePath) {
+    FILE* file = (filePath != nullptr) ? fopen(filePath, "rb") : NULL;
+    if (file == NULL) {
+        InValidate("Failed to open file");
+        return false;
+    }
+
+    bool res = Parse([file](char* buffer, u64 capacity) {
+        return static_cast<u64>(fread(buffer, sizeof(char), capacity, file));
+    });
+    fclose(file);
+    return res;
+}
+
+bool ByamlYamlParser::ParseString(const char* text, u64 size) {
+    if (text == nullptr) {
+        InValidate("Invalid input");
+        return false;
+    }
+
+    u64 pos = 0;
+    return Parse([text, size, &pos](char* buffer, u64 capacity) {
+        u64 copySize = std::min(capacity, size - pos);
+        memcpy(buffer, text + pos, copySize);
+        pos += copySize;
+        return copySize;
+    });
+}
@@ -0,0 +1,535 @@
+/**
+ *
+ * CorpusGen.cpp
+ *
+ * Copyright (c) 2021-2025, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#include "CorpusGen.hpp"
+#include "SARCWriter.hpp"
+#include "Byaml.hpp"
+#include "CRC32.hpp"
+#include "SeadRandom.hpp"
+#include "ZstdStream.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static void PutU8(std::vector<u8>& out, u8 val) {
+    out.push_back(val);
+}
+
+//Little endian unless bigEndian is set, which only Byaml and SARC files use
+static void PutU16(std::vector<u8>& out, u16 val, bool bigEndian = false) {
+    out.push_back(bigEndian ? (val >> 8) : (val & 0xFF));
+    out.push_back(bigEndian ? (val & 0xFF) : (val >> 8));
+}
+
+static void PutU24(std::vector<u8>& out, u32 val, bool bigEndian = false) {
+    if (bigEndian) {
+        PutU8(out, (val >> 16) & 0xFF);
+        PutU16(out, val & 0xFFFF, true);
+        return;
+    }
+    PutU16(out, val & 0xFFFF);
+    PutU8(out, (val >> 16) & 0xFF);
+}
+
+static void PutU32(std::vector<u8>& out, u32 val, bool bigEndian = false) {
+    PutU16(out, bigEndian ? (val >> 16) : (val & 0xFFFF), bigEndian);
+    PutU16(out, bigEndian ? (val & 0xFFFF) : (val >> 16), bigEndian);
+}
+
+static void PutU64(std::vector<u8>& out, u64 val, bool bigEndian = false) {
+    PutU32(out, bigEndian ? (val >> 32) : (val & 0xFFFFFFFF), bigEndian);
+    PutU32(out, bigEndian ? (val & 0xFFFFFFFF) : (val >> 32), bigEndian);
+}
+
+static void PutBytes(std::vector<u8>& out, const void* data, size_t size) {
+    const u8* bytes = static_cast<const u8*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+static void SetU32(std::vector<u8>& out, size_t offset, u32 val, bool bigEndian = false) {
+    for (u32 i = 0; i < 4; i++)
+        out[offset + (bigEndian ? 3 - i : i)] = (val >> (8 * i)) & 0xFF;
+}
+
+static void SwapAt(std::vector<u8>& out, size_t offset, size_t size) { //In place, little <-> big endian
+    std::reverse(out.begin() + offset, out.begin() + offset + size);
+}
+
+//SARCWriter only writes little endian archives, so the header fields are swapped afterwards (names and data are bytes)
+static void SwapSARCHeaders(std::vector<u8>& out) {
+    static const size_t SARCHeaderSize = 0x14, SFATHeaderSize = 0xC, SFATNodeSize = 0x10;
+    SwapAt(out, 0x4, 2); //Header Size
+    out[0x6] = 0xFE; //Big Endian BOM
+    out[0x7] = 0xFF;
+    SwapAt(out, 0x8, 4); //File Size
+    SwapAt(out, 0xC, 4); //Data Offset
+    SwapAt(out, 0x10, 2); //Version
+
+    u16 nodeCount = out[SARCHeaderSize + 6] | (out[SARCHeaderSize + 7] << 8);
+    SwapAt(out, SARCHeaderSize + 4, 2); //SFAT Header Size
+    SwapAt(out, SARCHeaderSize + 6, 2); //Node Count
+    SwapAt(out, SARCHeaderSize + 8, 4); //Hash Key
+
+    size_t node = SARCHeaderSize + SFATHeaderSize;
+    for (u16 i = 0; i < nodeCount; i++, node += SFATNodeSize) {
+        for (size_t field = 0; field < SFATNodeSize; field += 4) //Name Hash, Attributes, Data Begin, Data End
+            SwapAt(out, node + field, 4);
+    }
+    SwapAt(out, node + 4, 2); //SFNT Header Size
+}
+
+static void Align(std::vector<u8>& out, size_t alignment, u8 fill = 0) {
+    while (out.size() % alignment)
+        out.push_back(fill);
+}
+
+static u32 RandomRange(sead::Random& random, u32 max) { //[0, max)
+    return static_cast<u32>((static_cast<u64>(random.GetU32()) * max) >> 32);
+}
+
+std::string CorpusGen::SARCFileName(u32 index) {
+    char name[64];
+    snprintf(name, sizeof(name), "Corpus/Dir%u/File%05u.byml", index % 16, index);
+    return name;
+}
+
+std::string CorpusGen::BCSVColumnName(u16 index) {
+    static const char* const ColumnNames[] = { "UniqueID", "Label", "Price", "Weight", "Flag", "Category", "Kind" };
+    static const u16 NameCount = sizeof(ColumnNames) / sizeof(ColumnNames[0]);
+
+    std::string name = ColumnNames[index % NameCount];
+    if (index >= NameCount)
+        name += "_" + std::to_string(index / NameCount);
+    return name;
+}
+
+std::string CorpusGen::MSBTLabel(u32 index) {
+    char label[0x20];
+    snprintf(label, sizeof(label), "Label_%06u", index);
+    return label;
+}
+
+std::vector<u8> CorpusGen::MakeSARC(const SARCGenParams& params) {
+    u32 fileCount = std::min<u32>(params.fileCount, 0x3FFF);
+    std::vector<u8> fileData(static_cast<u64>(fileCount) * params.fileSize);
+    sead::Random random(params.seed);
+    for (auto& byte : fileData)
+        byte = static_cast<u8>(random.GetU32() >> 24);
+
+    SARCWriter writer;
+    for (u32 i = 0; i < fileCount; i++)
+        writer.AddFile(SARCFileName(i).c_str(), fileData.data() + (static_cast<u64>(i) * params.fileSize), params.fileSize);
+
+    std::vector<u8> out(writer.GetSize());
+    writer.WriteTo(out.data(), out.size());
+    if (params.bigEndian)
+        SwapSARCHeaders(out);
+    return out;
+}
+
+std::vector<u8> CorpusGen::MakeZstdFrame(const std::vector<u8>& data) {
+    std::vector<u8> out(ZstdStream::GetFrameBound(data.size()));
+    out.resize(ZstdStream::WriteFrame(out.data(), out.size(), data.data(), data.size(), 0));
+    return out;
+}
+
+std::vector<u8> CorpusGen::MakeBCSV(const BCSVGenParams& params) {
+    enum GenColumn { Gen_U32, Gen_String, Gen_Float, Gen_U8, Gen_U16 };
+    static const GenColumn ColumnPattern[] = { Gen_U32, Gen_String, Gen_U32, Gen_Float, Gen_U8, Gen_U8, Gen_U16 };
+    static const u32 ColumnSizes[] = { 4, 0x20, 4, 1, 2 };
+    static const u16 PatternSize = sizeof(ColumnPattern) / sizeof(ColumnPattern[0]);
+
+    u16 columnCount = params.columnCount ? params.columnCount : 1;
+    std::vector<u32> offsets(columnCount);
+    u32 rowSize = 0;
+    for (u16 i = 0; i < columnCount; i++) {
+        offsets[i] = rowSize;
+        rowSize += ColumnSizes[ColumnPattern[i % PatternSize]];
+    }
+
+    u32 startPos = (params.version == 0) ? 0xC : 0x1C;
+    std::vector<u8> out;
+    out.reserve(startPos + (columnCount * 8) + (static_cast<u64>(params.rowCount) * rowSize));
+    PutU32(out, params.rowCount);
+    PutU32(out, rowSize);
+    PutU16(out, columnCount);
+    PutU8(out, params.version == 0 ? 0 : 1);
+    PutU8(out, 1);
+    if (params.version != 0) {
+        PutBytes(out, "VSCB", 4);
+    }
+    out.resize(startPos, 0);
+
+    for (u16 i = 0; i < columnCount; i++) {
+        PutU32(out, CRC32::Calc(BCSVColumnName(i).c_str()));
+        PutU32(out, offsets[i]);
+    }
+
+    sead::Random random(params.seed);
+    char label[0x20];
+    for (u32 row = 0; row < params.rowCount; row++) {
+        for (u16 col = 0; col < columnCount; col++) {
+            switch (ColumnPattern[col % PatternSize]) {
+                case Gen_U32:
+                    PutU32(out, (col == 0) ? (0x1000 + row) : RandomRange(random, 100000)); //First column is a unique ID
+                    break;
+
+                case Gen_String:
+                    memset(label, 0, sizeof(label));
+                    snprintf(label, sizeof(label), "Item_%06u_%u", row, col);
+                    PutBytes(out, label, sizeof(label));
+                    break;
+
+                case Gen_Float: {
+                    float val = 0.5f + static_cast<float>(RandomRange(random, 1000)) / 4.0f;
+                    PutBytes(out, &val, sizeof(float));
+                    break;
+                }
+
+                case Gen_U8:
+                    PutU8(out, static_cast<u8>(RandomRange(random, 256)));
+                    break;
+
+                case Gen_U16:
+                    PutU16(out, static_cast<u16>(RandomRange(random, 0x10000)));
+                    break;
+            }
+        }
+    }
+    return out;
+}
+
+struct GenNode {
+    NodeType type = NodeType::Null;
+    u64 value = 0;
+    std::vector<GenNode> array;
+    std::vector<std::pair<u32, GenNode>> hash; //Key index -> value
+};
+
+static GenNode MakeValue(NodeType type, u64 value) {
+    GenNode node;
+    node.type = type;
+    node.value = value;
+    return node;
+}
+
+static bool IsGenContainer(NodeType type) {
+    return type == NodeType::Array || type == NodeType::Hash;
+}
+
+static bool IsGen64Bit(NodeType type) {
+    return type == NodeType::Int64 || type == NodeType::UInt64 || type == NodeType::Double;
+}
+
+static void WriteStringTable(std::vector<u8>& out, const std::vector<std::string>& strings, bool bigEndian) {
+    size_t start = out.size();
+    PutU8(out, static_cast<u8>(NodeType::StringTable));
+    PutU24(out, static_cast<u32>(strings.size()), bigEndian);
+
+    size_t offsetTable = out.size();
+    out.resize(out.size() + (4 * (strings.size() + 1)));
+    for (size_t i = 0; i < strings.size(); i++) {
+        SetU32(out, offsetTable + (4*i), static_cast<u32>(out.size() - start), bigEndian);
+        PutBytes(out, strings[i].c_str(), strings[i].size() + 1);
+    }
+    SetU32(out, offsetTable + (4*strings.size()), static_cast<u32>(out.size() - start), bigEndian);
+    Align(out, 4);
+}
+
+static u32 WriteContainer(std::vector<u8>& out, const GenNode& node, bool bigEndian);
+
+static void WriteValue(std::vector<u8>& out, size_t valueOffset, const GenNode& node, bool bigEndian) {
+    if (IsGenContainer(node.type)) {
+        SetU32(out, valueOffset, WriteContainer(out, node, bigEndian), bigEndian);
+    }
+    else if (IsGen64Bit(node.type)) {
+        SetU32(out, valueOffset, static_cast<u32>(out.size()), bigEndian);
+        PutU64(out, node.value, bigEndian);
+    }
+    else {
+        SetU32(out, valueOffset, static_cast<u32>(node.value), bigEndian);
+    }
+}
+
+static u32 WriteContainer(std::vector<u8>& out, const GenNode& node, bool bigEndian) {
+    u32 start = static_cast<u32>(out.size());
+    std::vector<size_t> valueOffsets;
+
+    PutU8(out, static_cast<u8>(node.type));
+    if (node.type == NodeType::Array) {
+        PutU24(out, static_cast<u32>(node.array.size()), bigEndian);
+        for (const auto& child : node.array)
+            PutU8(out, static_cast<u8>(child.type));
+        Align(out, 4);
+
+        for (size_t i = 0; i < node.array.size(); i++) {
+            valueOffsets.push_back(out.size());
+            PutU32(out, 0);
+        }
+
+        for (size_t i = 0; i < node.array.size(); i++)
+            WriteValue(out, valueOffsets[i], node.array[i], bigEndian);
+    }
+    else { //Entries are already sorted by key index
+        PutU24(out, static_cast<u32>(node.hash.size()), bigEndian);
+        for (const auto& elem : node.hash) {
+            PutU24(out, elem.first, bigEndian);
+            PutU8(out, static_cast<u8>(elem.second.type));
+            valueOffsets.push_back(out.size());
+            PutU32(out, 0);
+        }
+
+        for (size_t i = 0; i < node.hash.size(); i++)
+            WriteValue(out, valueOffsets[i], node.hash[i].second, bigEndian);
+    }
+    return start;
+}
+
+static std::vector<u8> WriteByaml(u16 version, const GenNode& root, const std::vector<std::string>& keys, const std::vector<std::string>& strings, bool bigEndian = false) {
+    std::vector<u8> out;
+    PutBytes(out, bigEndian ? "BY" : "YB", 2);
+    PutU16(out, version, bigEndian);
+    PutU32(out, 0); //Hash Key Table
+    PutU32(out, 0); //String Table
+    PutU32(out, 0); //Root
+
+    if (!keys.empty()) {
+        SetU32(out, 0x4, static_cast<u32>(out.size()), bigEndian);
+        WriteStringTable(out, keys, bigEndian);
+    }
+
+    if (!strings.empty()) {
+        SetU32(out, 0x8, static_cast<u32>(out.size()), bigEndian);
+        WriteStringTable(out, strings, bigEndian);
+    }
+
+    SetU32(out, 0xC, WriteContainer(out, root, bigEndian), bigEndian);
+    return out;
+}
+
+static GenNode MakeGenTree(sead::Random& random, const ByamlGenParams& params, u32 depth) {
+    static const NodeType LeafTypes[] = {
+        NodeType::String, NodeType::Bool, NodeType::Int, NodeType::Float, NodeType::UInt,
+        NodeType::Int64, NodeType::UInt64, NodeType::Double //Version 3+ only
+    };
+
+    if (depth == 0) {
+        u32 typeCount = (params.version >= 3) ? 8 : 5;
+        NodeType type = LeafTypes[RandomRange(random, typeCount)];
+        if (type == NodeType::String && params.stringCount == 0)
+            type = NodeType::UInt;
+
+        switch (type) {
+            case NodeType::String:
+                return MakeValue(type, RandomRange(random, params.stringCount));
+            case NodeType::Bool:
+                return MakeValue(type, random.GetU32() & 1);
+            case NodeType::Float: {
+                float val = static_cast<float>(RandomRange(random, 100000)) / 8.0f;
+                u32 bits;
+                memcpy(&bits, &val, sizeof(bits));
+                return MakeValue(type, bits);
+            }
+            case NodeType::Double: {
+                double val = static_cast<double>(random.GetU32()) / 16.0;
+                u64 bits;
+                memcpy(&bits, &val, sizeof(bits));
+                return MakeValue(type, bits);
+            }
+            case NodeType::Int64:
+            case NodeType::UInt64:
+                return MakeValue(type, random.GetU64());
+            default:
+                return MakeValue(type, random.GetU32());
+        }
+    }
+
+    GenNode node;
+    node.type = (random.GetU32() & 1 || params.keyCount == 0) ? NodeType::Array : NodeType::Hash;
+    if (node.type == NodeType::Array) {
+        for (u32 i = 0; i < params.fanOut; i++)
+            node.array.push_back(MakeGenTree(random, params, depth - 1));
+    }
+    else { //Consecutive (wrapping) keys are unique, sorted afterwards
+        u32 childCount = std::min(params.fanOut, params.keyCount);
+        u32 firstKey = RandomRange(random, params.keyCount);
+        for (u32 i = 0; i < childCount; i++)
+            node.hash.emplace_back((firstKey + i) % params.keyCount, MakeGenTree(random, params, depth - 1));
+
+        std::sort(node.hash.begin(), node.hash.end(), [](const std::pair<u32, GenNode>& a, const std::pair<u32, GenNode>& b) { return a.first < b.first; });
+    }
+    return node;
+}
+
+std::vector<u8> CorpusGen::MakeByaml(const ByamlGenParams& params) {
+    char text[0x20];
+    std::vector<std::string> keys(params.keyCount);
+    for (u32 i = 0; i < params.keyCount; i++) {
+        snprintf(text, sizeof(text), "%08x", i * 0x9E3779B9U);
+        keys[i] = text;
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    std::vector<std::string> strings(params.stringCount);
+    for (u32 i = 0; i < params.stringCount; i++) {
+        snprintf(text, sizeof(text), "String_%08u", i);
+        strings[i] = text;
+    }
+
+    ByamlGenParams treeParams = params;
+    treeParams.keyCount = static_cast<u32>(keys.size());
+    treeParams.depth = params.depth ? params.depth : 1; //Root must be a container
+
+    sead::Random random(params.seed);
+    GenNode root = MakeGenTree(random, treeParams, treeParams.depth);
+    return WriteByaml(params.version, root, keys, strings, params.bigEndian);
+}
+
+std::vector<u8> CorpusGen::MakeSaveLayoutByaml(u32 typeCount, u32 memberCount, bool bigEndian) {
+    //Sorted: 25efa387 == "Name", 5c65d8b5 == "TypeName", a2fb4a94 == "Members", a7bb2e42 == "Offset", b4a58247 == "Size"
+    static const u32 KeyName = 0, KeyTypeName = 1, KeyMembers = 2, KeyOffset = 3, KeySize = 4;
+    const std::vector<std::string> keys = { "25efa387", "5c65d8b5", "a2fb4a94", "a7bb2e42", "b4a58247" };
+
+    GenNode root;
+    root.type = NodeType::Array;
+    for (u32 i = 0; i < typeCount; i++) {
+        GenNode members;
+        members.type = NodeType::Array;
+        u64 offset = 0;
+        for (u32 j = 0; j < memberCount; j++) {
+            u64 size = 4 + ((j % 8) * 4);
+            GenNode member;
+            member.type = NodeType::Hash;
+            member.hash.emplace_back(KeyName, MakeValue(NodeType::UInt, 0x10000 + j));
+            member.hash.emplace_back(KeyTypeName, MakeValue(NodeType::UInt, (j % 4 == 0) ? (i + 1) % typeCount : 0xFFFF0000 + j));
+            member.hash.emplace_back(KeyOffset, MakeValue(NodeType::Int64, offset));
+            member.hash.emplace_back(KeySize, MakeValue(NodeType::Int64, size));
+            members.array.push_back(member);
+            offset += size;
+        }
+
+        GenNode type;
+        type.type = NodeType::Hash;
+        type.hash.emplace_back(KeyTypeName, MakeValue(NodeType::UInt, i));
+        type.hash.emplace_back(KeyMembers, members);
+        type.hash.emplace_back(KeySize, MakeValue(NodeType::Int64, offset));
+        root.array.push_back(type);
+    }
+    return WriteByaml(3, root, keys, std::vector<std::string>(), bigEndian);
+}
+
+static u32 MSBTLabelSlot(const std::string& label, u32 slotCount) { //Bucket the game looks a label up in
+    u32 hash = 0;
+    for (char c : label)
+        hash = (hash * 0x492) + static_cast<u8>(c);
+    return hash % slotCount;
+}
+
+std::vector<u8> CorpusGen::MakeMSBT(const MSBTGenParams& params) {
+    static const u32 SlotCount = 101;
+    bool utf16 = params.encoding == Encoding_UTF16;
+
+    std::vector<std::vector<u32>> slots(SlotCount);
+    for (u32 i = 0; i < params.entryCount; i++)
+        slots[MSBTLabelSlot(MSBTLabel(i), SlotCount)].push_back(i);
+
+    std::vector<u8> lbl1;
+    PutU32(lbl1, SlotCount);
+    size_t labelPos = 4 + (SlotCount * 8);
+    for (u32 i = 0; i < SlotCount; i++) {
+        PutU32(lbl1, static_cast<u32>(slots[i].size()));
+        PutU32(lbl1, static_cast<u32>(labelPos));
+        for (u32 index : slots[i])
+            labelPos += 1 + MSBTLabel(index).size() + 4;
+    }
+    for (u32 i = 0; i < SlotCount; i++) {
+        for (u32 index : slots[i]) {
+            std::string label = MSBTLabel(index);
+            PutU8(lbl1, static_cast<u8>(label.size()));
+            PutBytes(lbl1, label.c_str(), label.size());
+            PutU32(lbl1, index);
+        }
+    }
+
+    sead::Random random(params.seed);
+    std::vector<u8> txt2;
+    PutU32(txt2, params.entryCount);
+    txt2.resize(4 + (params.entryCount * 4));
+    for (u32 i = 0; i < params.entryCount; i++) {
+        SetU32(txt2, 4 + (i * 4), static_cast<u32>(txt2.size()));
+        for (u32 j = 0; j <= params.textLength; j++) { //Including null terminator
+            u8 c = (j == params.textLength) ? 0 : static_cast<u8>('a' + RandomRange(random, 26));
+            if (utf16)
+                PutU16(txt2, c);
+            else
+                PutU8(txt2, c);
+        }
+    }
+
+    std::vector<u8> out;
+    PutBytes(out, "MsgStdBn", 8);
+    PutU8(out, 0xFF); //Little Endian BOM
+    PutU8(out, 0xFE);
+    PutU16(out, 0);
+    PutU8(out, utf16 ? Encoding_UTF16 : Encoding_UTF8);
+    PutU8(out, 3);
+    PutU16(out, 2); //Section Count
+    PutU16(out, 0);
+    PutU32(out, 0); //File Size
+    out.resize(0x20, 0);
+
+    const std::pair<const char*, std::vector<u8>*> sections[] = { {"LBL1", &lbl1}, {"TXT2", &txt2} };
+    for (const auto& section : sections) {
+        PutBytes(out, section.first, 4);
+        PutU32(out, static_cast<u32>(section.second->size()));
+        out.resize(out.size() + 8, 0);
+        PutBytes(out, section.second->data(), section.second->size());
+        Align(out, 16, 0xAB);
+    }
+    SetU32(out, 0x12, static_cast<u32>(out.size()));
+    return out;
+}
+
+std::vector<u8> CorpusGen::MakeBFTTF(u32 fontSize) {
+    static const u32 SwitchMagic = 0x1E1AF836;
+    static const u32 SwitchKey = 0x49621806;
+
+    fontSize &= ~3;
+    std::vector<u8> out;
+    out.reserve(8 + fontSize);
+    PutU32(out, SwitchMagic);
+    PutU32(out, __builtin_bswap32(fontSize ^ SwitchKey));
+    for (u32 i = 0; i < fontSize; i += 4)
+        PutU32(out, i * 0x9E3779B9);
+    return out;
+}
+
+bool CorpusGen::WriteFile(const std::string& filePath, const std::vector<u8>& data) {
+    FILE* file = fopen(filePath.c_str(), "wb");
+    if (file == NULL)
+        return false;
+
+    size_t written = fwrite(data.data(), sizeof(u8), data.size(), file);
+    fclose(file);
+    return written == data.size();
+}
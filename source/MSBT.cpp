@@ -21,6 +21,7 @@
  */
 
 #include "MSBT.hpp"
+#include "MemoryMap.hpp"
 #include <cstdio>
 #include <string>
 #include <cstring>
@@ -28,7 +29,19 @@
 #include <locale>
 #include <codecvt>
 
-MSBT::MSBT(const char* filePath) {
+MSBT::MSBT(const char* filePath, bool mapFile) {
+    if (mapFile && MemoryMap::IsSupported()) {
+        this->data = MemoryMap::Map(filePath, this->dataSize);
+        if (this->data == nullptr) {
+            InValidate("Failed to map file");
+            return;
+        }
+
+        autoUnmapMem = true;
+        this->Init();
+        return;
+    }
+
     FILE* file = fopen(filePath, "r");
     if (file == NULL) {
         InValidate("Failed to open file");
@@ -65,6 +78,11 @@ MSBT::~MSBT() {
         delete[] this->data;
         autoManageMem = false;
     }
+
+    if (autoUnmapMem) {
+        MemoryMap::Unmap(this->data, this->dataSize);
+        autoUnmapMem = false;
+    }
 }
 
 void MSBT::Init() {
@@ -174,7 +192,7 @@ void MSBT::Parse() {
         }
 
         else {
-            std::u16string str((const char16_t*)(text.stringBytes), text.stringSize);
+            std::u16string str((const char16_t*)(text.stringBytes), text.stringSize / sizeof(char16_t)); //stringSize is in bytes
             std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> convert;
             textStr = convert.to_bytes(str);
         }
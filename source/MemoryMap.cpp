@@ -0,0 +1,91 @@
+/**
+ *
+ * MemoryMap.cpp
+ *
+ * Copyright (c) 2021-2025, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#include "MemoryMap.hpp"
+
+#if !defined(__SWITCH__) && !defined(_MSC_VER)
+#define LIBACNH_HAS_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+bool MemoryMap::IsSupported() {
+#ifdef LIBACNH_HAS_MMAP
+    return true;
+#else
+    return false;
+#endif
+}
+
+u8* MemoryMap::Map(const char* filePath, u64& outSize) {
+    outSize = 0;
+#ifdef LIBACNH_HAS_MMAP
+    if (!filePath)
+        return nullptr;
+
+    int fd = open(filePath, O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) { //mmap can't map empty files
+        close(fd);
+        return nullptr;
+    }
+
+    void* address = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); //Mapping stays valid after the descriptor is closed
+    if (address == MAP_FAILED)
+        return nullptr;
+
+    outSize = static_cast<u64>(st.st_size);
+    return static_cast<u8*>(address);
+#else
+    (void)filePath;
+    return nullptr;
+#endif
+}
+
+void MemoryMap::Unmap(u8* address, u64 size) {
+#ifdef LIBACNH_HAS_MMAP
+    if (address != nullptr && size != 0)
+        munmap(address, size);
+#else
+    (void)address;
+    (void)size;
+#endif
+}
+
+bool MemoryMap::MakeWritable(u8* address, u64 size) {
+#ifdef LIBACNH_HAS_MMAP
+    if (address == nullptr || size == 0)
+        return false;
+
+    return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+#else
+    (void)address;
+    (void)size;
+    return false;
+#endif
+}
@@ -21,8 +21,10 @@
  */
 
 #include "SARC.hpp"
+#include "MemoryMap.hpp"
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 
 static const constexpr u8 SFATNodeSize = 0x10;
 
@@ -30,7 +32,19 @@ SARC::SARC() {
     
 }
 
-SARC::SARC(const char* filePath) {
+SARC::SARC(const char* filePath, bool mapFile) {
+    if (mapFile && MemoryMap::IsSupported()) {
+        this->data = MemoryMap::Map(filePath, this->dataSize);
+        if (this->data == nullptr) {
+            InValidate("Failed to map file");
+            return;
+        }
+
+        autoUnmapMem = true;
+        this->Init();
+        return;
+    }
+
     FILE* file = fopen(filePath, "r");
     if (file == NULL) {
         InValidate("Failed to open file");
@@ -67,6 +81,11 @@ SARC::~SARC() {
         delete[] this->data;
         autoManageMem = false;
     }
+
+    if (autoUnmapMem) {
+        MemoryMap::Unmap(this->data, this->dataSize);
+        autoUnmapMem = false;
+    }
 }
 
 void SARC::Init() { //Checks based on ACNH 1.5.0
@@ -81,8 +100,6 @@ void SARC::Init() { //Checks based on ACNH 1.5.0
 
     else if (data[6] == 0xFE && data[7] == 0xFF) { //Big Endian BOM
         bigEndian = true;
-        InValidate("Big Endian Unsupported"); //TODO: Technically supported but not tested
-        return;
     }
 
     else {
@@ -90,15 +107,23 @@ void SARC::Init() { //Checks based on ACNH 1.5.0
         return;
     }
 
-    u16 sarcHeaderSize = ReadU16(data + 4);
+    if (bigEndian)
+        this->InitTables<true>();
+    else
+        this->InitTables<false>();
+}
+
+template<bool BigEndian>
+void SARC::InitTables() {
+    u16 sarcHeaderSize = Endian::ReadU16<BigEndian>(data + 4);
     if (sarcHeaderSize != 0x14) { //SARC Header Size
         InValidate("Invalid SARC Header Size"); 
         return;
     }
 
-    this->dataOffset = ReadU32(data + 0xC);
+    this->dataOffset = Endian::ReadU32<BigEndian>(data + 0xC);
 
-    u16 version = ReadU16(data+0x10);
+    u16 version = Endian::ReadU16<BigEndian>(data+0x10);
     if (version != 0x100) {
         InValidate("Invalid Version");
         return;
@@ -111,28 +136,29 @@ void SARC::Init() { //Checks based on ACNH 1.5.0
         return;
     }
 
-    u16 sfatHeaderSize = ReadU16(data + sarcHeaderSize + 4);
+    u16 sfatHeaderSize = Endian::ReadU16<BigEndian>(data + sarcHeaderSize + 4);
     if (sfatHeaderSize != 0xC) { //SFAT Header Size
         InValidate("Invalid SFAT Header Size"); 
         return;
     }
 
     this->nodeAddress = sarcHeaderSize + sfatHeaderSize;
-    this->nodeCount = ReadU16(data + sarcHeaderSize + 6);
+    this->nodeCount = Endian::ReadU16<BigEndian>(data + sarcHeaderSize + 6);
+    this->hashKey = Endian::ReadU32<BigEndian>(data + sarcHeaderSize + 8);
     if ((nodeCount >> 0xE) != 0) {
         InValidate("Too many files"); 
         return;
     }
 
     /* SFNT - File Name Table */
-    u16 sfntHeaderOffset = nodeAddress + (SFATNodeSize*nodeCount);
+    u32 sfntHeaderOffset = nodeAddress + (SFATNodeSize*nodeCount);
     if (data[sfntHeaderOffset] != 'S' || data[sfntHeaderOffset+1] != 'F' ||
         data[sfntHeaderOffset+2] != 'N' || data[sfntHeaderOffset+3] != 'T') { //SFNT Magic
         InValidate("Invalid SFNT Magic"); 
         return;
     }
 
-    u16 sfntHeaderSize = ReadU16(data + sfntHeaderOffset + 4);
+    u16 sfntHeaderSize = Endian::ReadU16<BigEndian>(data + sfntHeaderOffset + 4);
     if (sfntHeaderSize != 0x8) { //SFNT Header Size
         InValidate("Invalid SFNT Header Size");
         return;
@@ -143,7 +169,7 @@ void SARC::Init() { //Checks based on ACNH 1.5.0
         return;
     }
 
-    this->Parse();
+    this->Parse<BigEndian>();
 }
 
 bool SARC::IsValid() const {
@@ -154,33 +180,131 @@ const char* SARC::GetErrorMessage() const {
     return errorMessage;
 }
 
+bool SARC::IsBigEndian() const {
+    return bigEndian;
+}
+
+template<bool BigEndian>
 void SARC::Parse() {
     fileInfo.clear();
     
     u32 offset = this->nodeAddress;
     for (u16 i = 0; i < this->nodeCount; i++, offset += SFATNodeSize) {
-        //u32 nameHash = ReadU32(data+offset);
-        u32 fileAttributes = ReadU32(data+offset+0x4);
+        u32 nameHash = Endian::ReadU32<BigEndian>(data+offset);
+        u32 fileAttributes = Endian::ReadU32<BigEndian>(data+offset+0x4);
         if (fileAttributes == 0) { //Unnamed Files
             continue;
         }
 
         //u8 flags = fileAttributes >> 24;
         u32 nameOffset = fileAttributes & 0xffffff;
-        u32 dataBegin = ReadU32(data+offset+0x8);
-        u32 dataEnd = ReadU32(data+offset+0xC);
+        u32 dataBegin = Endian::ReadU32<BigEndian>(data+offset+0x8);
+        u32 dataEnd = Endian::ReadU32<BigEndian>(data+offset+0xC);
 
         u32 nameTableOffset = this->nameTableAddress + (4*nameOffset);
         if (nameTableOffset > this->dataOffset) {
             continue;
         }
 
-        SARCFileInfo info; 
+        SARCFileInfo info;
+        info.nameHash = nameHash;
         info.name = reinterpret_cast<const char*>(data + nameTableOffset);
         info.dataAddress = data+dataOffset+dataBegin;
         info.dataSize = dataEnd - dataBegin;
         fileInfo.push_back(info);
     }
+
+    //SFAT nodes are stored sorted by hash, only sort if a file breaks that rule
+    auto compareHash = [](const SARCFileInfo& a, const SARCFileInfo& b) { return a.nameHash < b.nameHash; };
+    if (!std::is_sorted(fileInfo.begin(), fileInfo.end(), compareHash)) {
+        std::stable_sort(fileInfo.begin(), fileInfo.end(), compareHash);
+    }
+}
+
+const SARCFileInfo* SARC::FindFile(u32 nameHash) const {
+    auto it = std::lower_bound(fileInfo.begin(), fileInfo.end(), nameHash,
+        [](const SARCFileInfo& info, u32 hash) { return info.nameHash < hash; });
+
+    if (it == fileInfo.end() || it->nameHash != nameHash) {
+        return nullptr;
+    }
+    return &(*it);
+}
+
+const SARCFileInfo* SARC::FindFile(const char* sarcFilePath) const {
+    u32 nameHash = CalcNameHash(sarcFilePath, this->hashKey);
+    const SARCFileInfo* info = FindFile(nameHash);
+    if (info == nullptr) {
+        return nullptr;
+    }
+
+    //Hash collisions are stored next to each other, so only those entries need a name compare
+    const SARCFileInfo* end = fileInfo.data() + fileInfo.size();
+    for (; info != end && info->nameHash == nameHash; info++) {
+        if (strcmp(info->name, sarcFilePath) == 0) {
+            return info;
+        }
+    }
+    return nullptr;
+}
+
+bool SARC::GetFileInfoByHash(SARCFileInfo& outInfo, u32 nameHash) {
+    if (!this->isValid)
+        return false;
+
+    const SARCFileInfo* info = FindFile(nameHash);
+    if (info == nullptr) {
+        return false;
+    }
+
+    if (!LoadFile(*info)) {
+        return false;
+    }
+
+    outInfo = *info;
+    return true;
+}
+
+bool SARC::GetFileInfo(SARCFileInfo& outInfo, const char* sarcFilePath) {
+    if (!this->isValid || !sarcFilePath)
+        return false;
+
+    const SARCFileInfo* info = FindFile(sarcFilePath);
+    if (info == nullptr) {
+        return false;
+    }
+
+    if (!LoadFile(*info)) {
+        return false;
+    }
+
+    outInfo = *info;
+    return true;
+}
+
+bool SARC::GetFileInfoByIndex(SARCFileInfo& outInfo, u32 index) {
+    if (!this->isValid || index >= fileInfo.size())
+        return false;
+
+    if (!LoadFile(fileInfo[index])) {
+        return false;
+    }
+
+    outInfo = fileInfo[index];
+    return true;
+}
+
+bool SARC::LoadFile(const SARCFileInfo& info) {
+    (void)info; //Whole archive is already in memory
+    return true;
+}
+
+u32 SARC::GetFileCount() const {
+    return this->isValid ? static_cast<u32>(fileInfo.size()) : 0;
+}
+
+u32 SARC::GetHashKey() const {
+    return hashKey;
 }
 
 void SARC::Print() {
@@ -194,18 +318,11 @@ void SARC::Print() {
 bool SARC::GetFile(const char *outFile, const char *sarcFilePath) {
     static const constexpr u64 BLOCK_SIZE = 0x200000;
 
-    if (!this->isValid || !outFile || !sarcFilePath)
+    if (!outFile)
         return false;
 
-    SARCFileInfo fInfo; fInfo.name = nullptr;
-    for (auto& info : fileInfo) {
-        if (strcmp(info.name, sarcFilePath) == 0) {
-            fInfo = info;
-            break;
-        }
-    }
-
-    if (fInfo.name == nullptr) {
+    SARCFileInfo fInfo;
+    if (!GetFileInfo(fInfo, sarcFilePath)) {
         return false;
     }
 
@@ -214,11 +331,6 @@ bool SARC::GetFile(const char *outFile, const char *sarcFilePath) {
         return false;
     }
 
-    u8* buffer = new u8[BLOCK_SIZE];
-    if (!buffer) {
-        return false;
-    }
-
     for (u64 offset = 0, blockSize = BLOCK_SIZE; offset < fInfo.dataSize; offset += blockSize) {
         if (blockSize > (fInfo.dataSize - offset))
             blockSize = (fInfo.dataSize - offset);
@@ -226,12 +338,10 @@ bool SARC::GetFile(const char *outFile, const char *sarcFilePath) {
         size_t written = fwrite(fInfo.dataAddress+offset, sizeof(u8), blockSize, file);
         if (written != blockSize) {
             fclose(file);
-            delete[] buffer;
             return false;
         }
     }
 
     fclose(file);
-    delete[] buffer;
     return true;
 }
@@ -0,0 +1,388 @@
+/**
+ *
+ * SARCWriter.cpp
+ *
+ * Copyright (c) 2021-2021, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#include "SARCWriter.hpp"
+#include "ZstdStream.hpp"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+static const constexpr u32 SARCHeaderSize = 0x14;
+static const constexpr u32 SFATHeaderSize = 0xC;
+static const constexpr u32 SFATNodeSize = 0x10;
+static const constexpr u32 SFNTHeaderSize = 0x8;
+static const constexpr u32 MinAlignment = 4;
+static const constexpr u32 MaxAlignment = 0x2000;
+static const constexpr u32 MaxFileCount = 0x3FFF;
+static const constexpr u64 WriteBlockSize = 0x200000;
+
+static ALWAYS_INLINE u32 AlignUp(u32 value, u32 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static ALWAYS_INLINE void WriteU16(u8* out, u16 val) {
+    out[0] = val & 0xFF;
+    out[1] = val >> 8;
+}
+
+static ALWAYS_INLINE void WriteU32(u8* out, u32 val) {
+    WriteU16(out, val & 0xFFFF);
+    WriteU16(out + 2, val >> 16);
+}
+
+SARCWriter::SARCWriter(u32 hashKey) : hashKey(hashKey) {
+
+}
+
+bool SARCWriter::IsValid() const {
+    return isValid;
+}
+
+const char* SARCWriter::GetErrorMessage() const {
+    return errorMessage;
+}
+
+u32 SARCWriter::GetDefaultAlignment(const char* name, const u8* data, u32 dataSize) {
+    //Nested archives keep their files aligned relative to their start, so their data offset's alignment carries over
+    if (data != nullptr && dataSize >= SARCHeaderSize && memcmp(data, "SARC", 4) == 0) {
+        u32 nestedDataOffset = data[0xC] | (data[0xD] << 8) | (data[0xE] << 16) | (static_cast<u32>(data[0xF]) << 24);
+        u32 alignment = nestedDataOffset & (~nestedDataOffset + 1); //Lowest set bit
+        return std::min(std::max(alignment, MinAlignment), MaxAlignment);
+    }
+
+    //Switch binaries (BNTX, FRES, BNSH...) share nn::util::BinaryFileHeader, which stores log2(alignment) at 0xE
+    if (data != nullptr && dataSize >= 0x20 &&
+        ((data[0xC] == 0xFF && data[0xD] == 0xFE) || (data[0xC] == 0xFE && data[0xD] == 0xFF))) {
+        u8 shift = data[0xE];
+        if (shift >= 2 && shift <= 13)
+            return 1u << shift;
+    }
+
+    const char* extension = (name != nullptr) ? strrchr(name, '.') : nullptr;
+    if (extension == nullptr)
+        return MinAlignment;
+    extension++;
+
+    static const struct { const char* extension; u32 alignment; } TypeAlignments[] = {
+        { "byml", 8 }, { "byaml", 8 }, { "bgyml", 8 }, //64-bit values
+        { "bars", 0x20 }, { "bfwav", 0x20 }, { "bfstm", 0x20 }, { "bfsar", 0x20 },
+        { "bffnt", 0x1000 }, { "bfttf", 0x1000 }, { "bfotf", 0x1000 },
+    };
+
+    for (const auto& type : TypeAlignments) {
+        if (strcmp(extension, type.extension) == 0)
+            return type.alignment;
+    }
+    return MinAlignment;
+}
+
+bool SARCWriter::AddFile(const char* name, const u8* data, u32 dataSize, u32 alignment) {
+    if (name == nullptr || name[0] == '\0' || (data == nullptr && dataSize != 0)) {
+        InValidate("Invalid file entry");
+        return false;
+    }
+
+    if (alignment == 0)
+        alignment = GetDefaultAlignment(name, data, dataSize);
+
+    if ((alignment & (alignment - 1)) != 0) {
+        InValidate("Alignment must be a power of two");
+        return false;
+    }
+    alignment = std::max(alignment, MinAlignment);
+
+    auto it = entryIndices.find(name);
+    if (it != entryIndices.end()) {
+        SARCWriterEntry& entry = entries[it->second];
+        entry.data = data;
+        entry.dataSize = dataSize;
+        entry.alignment = alignment;
+    }
+    else {
+        if (entries.size() >= MaxFileCount) {
+            InValidate("Too many files");
+            return false;
+        }
+
+        SARCWriterEntry entry;
+        entry.name = name;
+        entry.nameHash = SARC::CalcNameHash(name, this->hashKey);
+        entry.data = data;
+        entry.dataSize = dataSize;
+        entry.alignment = alignment;
+        entryIndices.emplace(entry.name, static_cast<u32>(entries.size()));
+        entries.push_back(std::move(entry));
+    }
+
+    layoutDirty = true;
+    return true;
+}
+
+bool SARCWriter::AddFiles(SARC& sarc) {
+    if (!sarc.IsValid()) {
+        InValidate("Invalid source SARC");
+        return false;
+    }
+
+    SARCFileInfo info;
+    for (u32 i = 0; i < sarc.GetFileCount(); i++) {
+        if (!sarc.GetFileInfoByIndex(info, i) || !AddFile(info.name, info.dataAddress, info.dataSize))
+            return false;
+    }
+    return true;
+}
+
+bool SARCWriter::RemoveFile(const char* name) {
+    if (name == nullptr)
+        return false;
+
+    auto it = entryIndices.find(name);
+    if (it == entryIndices.end())
+        return false;
+
+    u32 index = it->second;
+    entryIndices.erase(it);
+    if (index != entries.size() - 1) { //Move the last entry into the hole
+        entries[index] = std::move(entries.back());
+        entryIndices[entries[index].name] = index;
+    }
+    entries.pop_back();
+
+    layoutDirty = true;
+    return true;
+}
+
+u32 SARCWriter::GetFileCount() const {
+    return static_cast<u32>(entries.size());
+}
+
+bool SARCWriter::Layout() {
+    if (!isValid)
+        return false;
+
+    if (!layoutDirty)
+        return true;
+
+    //Game files keep SFAT sorted by hash (SARC::FindFile relies on it); collisions are ordered by name
+    std::sort(entries.begin(), entries.end(), [](const SARCWriterEntry& a, const SARCWriterEntry& b) {
+        if (a.nameHash != b.nameHash)
+            return a.nameHash < b.nameHash;
+        return a.name < b.name;
+    });
+
+    nameOffsets.resize(entries.size());
+    dataBegins.resize(entries.size());
+
+    u32 nameTableSize = 0;
+    u32 maxAlignment = MinAlignment;
+    for (u32 i = 0; i < entries.size(); i++) {
+        entryIndices[entries[i].name] = i;
+        nameOffsets[i] = nameTableSize;
+        nameTableSize += AlignUp(static_cast<u32>(entries[i].name.size()) + 1, 4);
+        maxAlignment = std::max(maxAlignment, entries[i].alignment);
+    }
+
+    if ((nameTableSize / 4) > 0xFFFFFF) {
+        InValidate("Name table too large");
+        return false;
+    }
+
+    this->headersSize = SARCHeaderSize + SFATHeaderSize + (SFATNodeSize * static_cast<u32>(entries.size())) + SFNTHeaderSize + nameTableSize;
+    this->dataOffset = AlignUp(headersSize, maxAlignment); //Relative alignment inside the data section then holds in the file too
+
+    u64 dataPos = 0;
+    for (u32 i = 0; i < entries.size(); i++) {
+        dataPos = (dataPos + entries[i].alignment - 1) & ~static_cast<u64>(entries[i].alignment - 1);
+        dataBegins[i] = static_cast<u32>(dataPos);
+        dataPos += entries[i].dataSize;
+        if (dataOffset + dataPos > 0xFFFFFFFF) {
+            InValidate("Archive too large");
+            return false;
+        }
+    }
+
+    this->archiveSize = dataOffset + dataPos;
+    layoutDirty = false;
+    return true;
+}
+
+u64 SARCWriter::GetSize() {
+    return Layout() ? archiveSize : 0;
+}
+
+void SARCWriter::WriteHeaders(u8* out) const { //Writes [0, dataOffset)
+    memset(out, 0, dataOffset);
+
+    memcpy(out, "SARC", 4);
+    WriteU16(out + 0x4, SARCHeaderSize);
+    WriteU16(out + 0x6, 0xFEFF); //Little Endian BOM
+    WriteU32(out + 0x8, static_cast<u32>(archiveSize));
+    WriteU32(out + 0xC, dataOffset);
+    WriteU16(out + 0x10, 0x100);
+
+    u8* sfat = out + SARCHeaderSize;
+    memcpy(sfat, "SFAT", 4);
+    WriteU16(sfat + 0x4, SFATHeaderSize);
+    WriteU16(sfat + 0x6, static_cast<u16>(entries.size()));
+    WriteU32(sfat + 0x8, hashKey);
+
+    u8* node = sfat + SFATHeaderSize;
+    for (u32 i = 0; i < entries.size(); i++, node += SFATNodeSize) {
+        WriteU32(node, entries[i].nameHash);
+        WriteU32(node + 0x4, 0x01000000 | (nameOffsets[i] / 4)); //Flags: has name
+        WriteU32(node + 0x8, dataBegins[i]);
+        WriteU32(node + 0xC, dataBegins[i] + entries[i].dataSize);
+    }
+
+    u8* sfnt = node;
+    memcpy(sfnt, "SFNT", 4);
+    WriteU16(sfnt + 0x4, SFNTHeaderSize);
+
+    u8* names = sfnt + SFNTHeaderSize;
+    for (u32 i = 0; i < entries.size(); i++)
+        memcpy(names + nameOffsets[i], entries[i].name.c_str(), entries[i].name.size() + 1);
+}
+
+bool SARCWriter::WriteTo(u8* outBuffer, u64 bufSize) {
+    if (!Layout())
+        return false;
+
+    if (outBuffer == nullptr || bufSize < archiveSize) {
+        InValidate("Output buffer too small");
+        return false;
+    }
+
+    WriteHeaders(outBuffer);
+
+    u8* fileData = outBuffer + dataOffset;
+    u64 pos = 0;
+    for (u32 i = 0; i < entries.size(); i++) {
+        memset(fileData + pos, 0, dataBegins[i] - pos); //Alignment padding
+        if (entries[i].dataSize != 0)
+            memcpy(fileData + dataBegins[i], entries[i].data, entries[i].dataSize);
+        pos = static_cast<u64>(dataBegins[i]) + entries[i].dataSize;
+    }
+    return true;
+}
+
+u8* SARCWriter::Write(u64& outSize) {
+    outSize = 0;
+    if (!Layout())
+        return nullptr;
+
+    u8* out = new u8[archiveSize];
+    if (!WriteTo(out, archiveSize)) {
+        delete[] out;
+        return nullptr;
+    }
+
+    outSize = archiveSize;
+    return out;
+}
+
+bool SARCWriter::WriteFile(const char* filePath) {
+    if (filePath == nullptr || !Layout())
+        return false;
+
+    FILE* file = fopen(filePath, "wb");
+    if (file == NULL) {
+        InValidate("Failed to open file");
+        return false;
+    }
+
+    //Only the headers are staged, file data is written from the caller's buffers
+    std::vector<u8> headers(dataOffset);
+    WriteHeaders(headers.data());
+    bool ok = fwrite(headers.data(), sizeof(u8), headers.size(), file) == headers.size();
+
+    static const u8 Padding[MaxAlignment] = {0};
+    u64 pos = 0;
+    for (u32 i = 0; ok && i < entries.size(); i++) {
+        for (u64 padding = dataBegins[i] - pos, blockSize = MaxAlignment; ok && padding != 0; padding -= blockSize) {
+            if (blockSize > padding)
+                blockSize = padding;
+            ok = fwrite(Padding, sizeof(u8), blockSize, file) == blockSize;
+        }
+
+        for (u64 offset = 0, blockSize = WriteBlockSize; ok && offset < entries[i].dataSize; offset += blockSize) {
+            if (blockSize > (entries[i].dataSize - offset))
+                blockSize = (entries[i].dataSize - offset);
+            ok = fwrite(entries[i].data + offset, sizeof(u8), blockSize, file) == blockSize;
+        }
+        pos = static_cast<u64>(dataBegins[i]) + entries[i].dataSize;
+    }
+
+    if (fclose(file) != 0)
+        ok = false;
+
+    if (!ok)
+        InValidate("Failed to write file");
+    return ok;
+}
+
+u8* SARCWriter::WriteCompressed(u64& outSize, int level) {
+    outSize = 0;
+    u64 archiveBufSize = 0;
+    u8* archive = Write(archiveBufSize);
+    if (archive == nullptr)
+        return nullptr;
+
+    u64 frameBound = ZstdStream::GetFrameBound(archiveBufSize);
+    u8* frame = new u8[frameBound];
+    u64 frameSize = ZstdStream::WriteFrame(frame, frameBound, archive, archiveBufSize, level);
+    delete[] archive;
+
+    if (frameSize == 0) {
+        delete[] frame;
+        InValidate("ZSTD: Compression failed");
+        return nullptr;
+    }
+
+    outSize = frameSize;
+    return frame;
+}
+
+bool SARCWriter::WriteCompressedFile(const char* filePath, int level) {
+    if (filePath == nullptr)
+        return false;
+
+    u64 frameSize = 0;
+    u8* frame = WriteCompressed(frameSize, level);
+    if (frame == nullptr)
+        return false;
+
+    FILE* file = fopen(filePath, "wb");
+    if (file == NULL) {
+        delete[] frame;
+        InValidate("Failed to open file");
+        return false;
+    }
+
+    bool ok = fwrite(frame, sizeof(u8), frameSize, file) == frameSize;
+    if (fclose(file) != 0)
+        ok = false;
+    delete[] frame;
+
+    if (!ok)
+        InValidate("Failed to write file");
+    return ok;
+}
@@ -25,6 +25,10 @@
 #include "SaveCrypto.hpp"
 #ifdef __SWITCH__
 #include <switch.h>
+#elif defined(LIBACNH_SYSTEM_AES)
+#include <openssl/evp.h>
+#include <climits>
+#include <cassert>
 #else
 #include "libaes.h"
 #endif
@@ -53,7 +57,7 @@ ALWAYS_INLINE void GetParam(u8* outParam, const u32 data[], const int index) {
         outParam[i] = (u8)(rand.GetU32() >> 24);
 }
 
-void SaveCrypto::Crypt(const GSaveVersion& header, u8* encryptedSave, const u32 saveSize) {
+bool SaveCrypto::Crypt(const GSaveVersion& header, u8* encryptedSave, const u32 saveSize) {
     u8 key[AES_BLOCK_LENGTH] = {0};
     u8 counter[AES_BLOCK_LENGTH] = {0};
     GetParam(key, header.headerCrypto, 0); //Get AES Key
@@ -63,9 +67,21 @@ void SaveCrypto::Crypt(const GSaveVersion& header, u8* encryptedSave, const u32
     Aes128CtrContext ctx;
     aes128CtrContextCreate(&ctx, key, counter);
     aes128CtrCrypt(&ctx, encryptedSave, encryptedSave, saveSize); //Crypt In-Place
+    return true;
+#elif defined(LIBACNH_SYSTEM_AES) //OpenSSL, uses AES-NI/ARMv8 crypto where available
+    //Update works in place, so after a failure part of the save may already be crypted; report it rather than crypt again
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    int outSize = 0;
+    bool crypted = ctx != NULL && saveSize <= INT_MAX &&
+        EVP_EncryptInit_ex(ctx, EVP_aes_128_ctr(), NULL, key, counter) == 1 &&
+        EVP_EncryptUpdate(ctx, encryptedSave, &outSize, encryptedSave, static_cast<int>(saveSize)) == 1; //Crypt In-Place
+    EVP_CIPHER_CTX_free(ctx);
+    assert(!crypted || static_cast<u32>(outSize) == saveSize); //CTR is a stream cipher, nothing is held back for Final
+    return crypted;
 #else //software fallback for other platforms
     AES_ctx ctx;
     AES_init_ctx_iv(&ctx, key, counter);
     AES_CTR_xcrypt_buffer(&ctx, encryptedSave, saveSize); //Crypt In-Place
+    return true;
 #endif
 }
@@ -0,0 +1,338 @@
+/**
+ *
+ * ZstdStream.cpp
+ *
+ * Copyright (c) 2021-2025, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#include "ZstdStream.hpp"
+#include "MemoryMap.hpp"
+#include "zstd.h"
+#include <cstring>
+
+static const constexpr u64 MinUnknownOutputSize = 0x10000;
+static const constexpr u32 MaxStoredBlockSize = 0x20000; //ZSTD_BLOCKSIZE_MAX
+static const constexpr u32 StoredFrameHeaderSize = 4 + 1 + 8; //Magic, descriptor, 8 byte content size
+
+struct ZstdContextCache {
+    ZSTD_DCtx* ctx = nullptr;
+
+    ~ZstdContextCache() {
+        if (ctx != nullptr)
+            ZSTD_freeDCtx(ctx);
+    }
+};
+
+static thread_local ZstdContextCache contextCache;
+
+ZSTD_DCtx* ZstdStream::AcquireContext() {
+    ZSTD_DCtx* dctx = contextCache.ctx;
+    if (dctx != nullptr) {
+        contextCache.ctx = nullptr;
+        ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+        return dctx;
+    }
+    return ZSTD_createDCtx();
+}
+
+void ZstdStream::ReleaseContext(ZSTD_DCtx* dctx) {
+    if (dctx == nullptr)
+        return;
+
+    if (contextCache.ctx == nullptr) { //Keep one context per thread for the next stream
+        contextCache.ctx = dctx;
+    }
+    else {
+        ZSTD_freeDCtx(dctx);
+    }
+}
+
+ZstdStream::ZstdStream(const char* filePath) {
+    if (filePath == nullptr) {
+        InValidate("ZSTD: Invalid file path");
+        return;
+    }
+
+    this->mappedData = MemoryMap::Map(filePath, this->mappedSize);
+    if (this->mappedData != nullptr) { //Compressed pages stay file-backed, so only the output is resident
+        this->srcData = this->mappedData;
+        this->srcSize = this->mappedSize;
+        this->Init();
+        return;
+    }
+
+    this->file = fopen(filePath, "rb");
+    if (this->file == NULL) {
+        InValidate("ZSTD: Failed to open file");
+        return;
+    }
+
+    this->inCapacity = ZSTD_DStreamInSize();
+    this->inBuffer = new u8[inCapacity];
+    if (!ReadInput()) {
+        InValidate("ZSTD: Empty input");
+        Finish();
+        return;
+    }
+    this->Init();
+}
+
+ZstdStream::ZstdStream(const u8* inBuffer, u64 bufSize) : srcData(inBuffer), srcSize(bufSize) {
+    if (inBuffer == nullptr || bufSize == 0) {
+        InValidate("ZSTD: Invalid input buffer");
+        return;
+    }
+
+    this->Init();
+}
+
+ZstdStream::~ZstdStream() {
+    Finish();
+    delete[] this->outData;
+    this->outData = nullptr;
+}
+
+void ZstdStream::Init() {
+    u64 frameSize = ZSTD_getFrameContentSize(srcData + srcPos, srcSize - srcPos);
+    if (frameSize == ZSTD_CONTENTSIZE_ERROR) {
+        InValidate("ZSTD: Invalid frame header");
+        Finish();
+        return;
+    }
+
+    if (frameSize == ZSTD_CONTENTSIZE_UNKNOWN) { //Output grows as needed
+        u64 compressedSize = this->mappedData ? this->mappedSize : this->srcSize;
+        if (this->file != NULL) {
+            long current = ftell(file);
+            fseek(file, 0, SEEK_END);
+            compressedSize = ftell(file);
+            fseek(file, current, SEEK_SET);
+        }
+
+        this->contentSizeKnown = false;
+        this->outCapacity = compressedSize * 4;
+        if (outCapacity < MinUnknownOutputSize)
+            outCapacity = MinUnknownOutputSize;
+    }
+    else {
+        this->contentSizeKnown = true;
+        this->contentSize = frameSize;
+        this->outCapacity = frameSize;
+    }
+
+    this->outData = new u8[outCapacity ? outCapacity : 1];
+    this->ctx = AcquireContext();
+    if (this->ctx == nullptr) {
+        InValidate("ZSTD: Failed to create context");
+        Finish();
+    }
+}
+
+bool ZstdStream::ReadInput() {
+    if (this->file == NULL) { //Mapped/caller buffers are consumed in one go
+        return false;
+    }
+
+    size_t res = fread(this->inBuffer, sizeof(u8), this->inCapacity, this->file);
+    this->srcData = this->inBuffer;
+    this->srcSize = res;
+    this->srcPos = 0;
+    return res != 0;
+}
+
+bool ZstdStream::GrowOutput() {
+    u64 newCapacity = outCapacity * 2;
+    u8* newData = new u8[newCapacity];
+    memcpy(newData, outData, outPos);
+    delete[] outData;
+
+    this->outData = newData;
+    this->outCapacity = newCapacity;
+    return true;
+}
+
+void ZstdStream::Finish() { //Input and context are no longer needed once the frame is done
+    ReleaseContext(this->ctx);
+    this->ctx = nullptr;
+
+    if (this->file != NULL) {
+        fclose(this->file);
+        this->file = NULL;
+    }
+
+    if (this->mappedData != nullptr) {
+        MemoryMap::Unmap(this->mappedData, this->mappedSize);
+        this->mappedData = nullptr;
+        this->mappedSize = 0;
+    }
+
+    delete[] this->inBuffer;
+    this->inBuffer = nullptr;
+    this->srcData = nullptr;
+    this->srcSize = this->srcPos = 0;
+}
+
+bool ZstdStream::IsValid() const {
+    return isValid;
+}
+
+const char* ZstdStream::GetErrorMessage() const {
+    return errorMessage;
+}
+
+bool ZstdStream::Decompress(u64 size) {
+    if (!IsValid())
+        return false;
+
+    while (!isFinished && outPos < size) {
+        if (srcPos == srcSize && !ReadInput()) {
+            InValidate("ZSTD: Unexpected end of input");
+            Finish();
+            return false;
+        }
+
+        if (outPos == outCapacity && !contentSizeKnown) {
+            GrowOutput();
+        }
+
+        //Only decode a little past the requested size, so partial requests stay cheap
+        u64 limit = size + ZSTD_DStreamOutSize();
+        if (limit > outCapacity || limit < size)
+            limit = outCapacity;
+
+        ZSTD_outBuffer output = { outData, static_cast<size_t>(limit), static_cast<size_t>(outPos) };
+        ZSTD_inBuffer input = { srcData, static_cast<size_t>(srcSize), static_cast<size_t>(srcPos) };
+        size_t ret = ZSTD_decompressStream(ctx, &output, &input);
+        if (ZSTD_isError(ret)) {
+            InValidate("ZSTD: Decompression error");
+            Finish();
+            return false;
+        }
+
+        if (ret == 0) { //End of frame
+            this->outPos = output.pos;
+            this->isFinished = true;
+            Finish();
+            if (contentSizeKnown && outPos != contentSize) {
+                InValidate("ZSTD: Content size mismatch");
+                return false;
+            }
+
+            this->contentSize = outPos;
+            this->contentSizeKnown = true;
+            return true;
+        }
+
+        if (output.pos == outPos && input.pos == srcPos && srcPos != srcSize) {
+            InValidate("ZSTD: No progress");
+            Finish();
+            return false;
+        }
+
+        this->outPos = output.pos;
+        this->srcPos = input.pos;
+    }
+    return true;
+}
+
+bool ZstdStream::DecompressAll() {
+    if (!Decompress(static_cast<u64>(-1)))
+        return false;
+
+    return isFinished;
+}
+
+bool ZstdStream::IsFinished() const {
+    return isFinished;
+}
+
+bool ZstdStream::IsContentSizeKnown() const {
+    return contentSizeKnown;
+}
+
+u8* ZstdStream::GetData() const {
+    return outData;
+}
+
+u64 ZstdStream::GetContentSize() const {
+    return contentSize;
+}
+
+u64 ZstdStream::GetDecompressedSize() const {
+    return outPos;
+}
+
+u8* ZstdStream::Release(u64& outSize) {
+    u8* released = this->outData;
+    outSize = this->outPos;
+
+    this->outData = nullptr;
+    this->outCapacity = this->outPos = 0;
+    return released;
+}
+
+u64 ZstdStream::GetFrameBound(u64 srcSize) {
+    u64 storedSize = StoredFrameHeaderSize + srcSize + (((srcSize / MaxStoredBlockSize) + 1) * 3);
+#ifdef LIBACNH_SYSTEM_ZSTD
+    u64 compressedSize = ZSTD_compressBound(static_cast<size_t>(srcSize));
+    return compressedSize > storedSize ? compressedSize : storedSize;
+#else
+    return storedSize;
+#endif
+}
+
+u64 ZstdStream::WriteFrame(u8* outBuffer, u64 outCapacity, const u8* src, u64 srcSize, int level) {
+    if (outBuffer == nullptr || (src == nullptr && srcSize != 0))
+        return 0;
+
+#ifdef LIBACNH_SYSTEM_ZSTD
+    if (level != 0) {
+        size_t ret = ZSTD_compress(outBuffer, static_cast<size_t>(outCapacity), src, static_cast<size_t>(srcSize), level);
+        return ZSTD_isError(ret) ? 0 : ret;
+    }
+#else
+    (void)level;
+#endif
+
+    if (outCapacity < StoredFrameHeaderSize + srcSize + (((srcSize / MaxStoredBlockSize) + 1) * 3))
+        return 0;
+
+    u8* out = outBuffer;
+    const u32 magic = 0xFD2FB528;
+    for (u32 i = 0; i < 4; i++)
+        *out++ = static_cast<u8>(magic >> (i * 8));
+    *out++ = 0xE0; //Frame Header Descriptor: 8 byte content size, single segment
+    for (u32 i = 0; i < 8; i++)
+        *out++ = static_cast<u8>(srcSize >> (i * 8));
+
+    u64 pos = 0;
+    do {
+        u32 blockSize = static_cast<u32>((srcSize - pos) < MaxStoredBlockSize ? (srcSize - pos) : MaxStoredBlockSize);
+        bool lastBlock = (pos + blockSize) == srcSize;
+        u32 blockHeader = (blockSize << 3) | (lastBlock ? 1 : 0); //Block type 0 == Raw
+        *out++ = blockHeader & 0xFF;
+        *out++ = (blockHeader >> 8) & 0xFF;
+        *out++ = (blockHeader >> 16) & 0xFF;
+        if (blockSize != 0)
+            memcpy(out, src + pos, blockSize);
+        out += blockSize;
+        pos += blockSize;
+    } while (pos < srcSize);
+
+    return static_cast<u64>(out - outBuffer);
+}
@@ -0,0 +1,123 @@
+/**
+ *
+ * corpusgen.cpp
+ *
+ * Copyright (c) 2021-2025, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#include "CorpusGen.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static void PrintUsage(const char* name) {
+    printf("Usage: %s <outDir> [options]\n", name);
+    printf("  --scale <n>   Multiplies file, row and entry counts (default 1)\n");
+    printf("  --depth <n>   Byaml container depth (default 3)\n");
+    printf("  --fanout <n>  Byaml children per container (default 8)\n");
+    printf("  --seed <n>    Random seed (default 0)\n");
+}
+
+static bool Write(const std::string& outDir, const char* fileName, const std::vector<u8>& data) {
+    std::string path = outDir + "/" + fileName;
+    if (!CorpusGen::WriteFile(path, data)) {
+        fprintf(stderr, "Failed to write %s\n", path.c_str());
+        return false;
+    }
+
+    printf("%-24s %12zu bytes\n", fileName, data.size());
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argv[1][0] == '-') {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::string outDir = argv[1];
+    u32 scale = 1, depth = 3, fanOut = 8, seed = 0;
+    for (int i = 2; i < argc; i++) {
+        if (i + 1 >= argc) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+
+        u32 value = static_cast<u32>(strtoul(argv[i + 1], nullptr, 0));
+        if (strcmp(argv[i], "--scale") == 0)
+            scale = value ? value : 1;
+        else if (strcmp(argv[i], "--depth") == 0)
+            depth = value;
+        else if (strcmp(argv[i], "--fanout") == 0)
+            fanOut = value;
+        else if (strcmp(argv[i], "--seed") == 0)
+            seed = value;
+        else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    bool ok = true;
+
+    SARCGenParams sarcParams;
+    sarcParams.fileCount = 100 * scale;
+    sarcParams.seed = seed;
+    std::vector<u8> sarc = CorpusGen::MakeSARC(sarcParams);
+    ok &= Write(outDir, "corpus.sarc", sarc);
+    ok &= Write(outDir, "corpus.sarc.zs", CorpusGen::MakeZstdFrame(sarc));
+    sarcParams.bigEndian = true;
+    ok &= Write(outDir, "corpus_be.sarc", CorpusGen::MakeSARC(sarcParams));
+
+    BCSVGenParams bcsvParams;
+    bcsvParams.rowCount = 1000 * scale;
+    bcsvParams.seed = seed;
+    for (u8 version = 0; version <= 1; version++) {
+        std::string name = "corpus_v" + std::to_string(version) + ".bcsv";
+        bcsvParams.version = version;
+        ok &= Write(outDir, name.c_str(), CorpusGen::MakeBCSV(bcsvParams));
+    }
+
+    ByamlGenParams byamlParams;
+    byamlParams.depth = depth;
+    byamlParams.fanOut = fanOut;
+    byamlParams.keyCount *= scale;
+    byamlParams.stringCount *= scale;
+    byamlParams.seed = seed;
+    for (u16 version = 1; version <= 4; version++) {
+        std::string name = "corpus_v" + std::to_string(version) + ".byml";
+        byamlParams.version = version;
+        ok &= Write(outDir, name.c_str(), CorpusGen::MakeByaml(byamlParams));
+    }
+    byamlParams.version = 3;
+    byamlParams.bigEndian = true;
+    ok &= Write(outDir, "corpus_be.byml", CorpusGen::MakeByaml(byamlParams));
+    ok &= Write(outDir, "save_layout.byml", CorpusGen::MakeSaveLayoutByaml(64 * scale, 32));
+
+    MSBTGenParams msbtParams;
+    msbtParams.entryCount = 1000 * scale;
+    msbtParams.seed = seed;
+    msbtParams.encoding = Encoding_UTF8;
+    ok &= Write(outDir, "corpus_utf8.msbt", CorpusGen::MakeMSBT(msbtParams));
+    msbtParams.encoding = Encoding_UTF16;
+    ok &= Write(outDir, "corpus_utf16.msbt", CorpusGen::MakeMSBT(msbtParams));
+
+    return ok ? 0 : 1;
+}
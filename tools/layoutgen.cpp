@@ -0,0 +1,206 @@
+/**
+ *
+ * layoutgen.cpp
+ *
+ * Copyright (c) 2021-2025, Slattz.
+ *
+ * This file is part of LibACNH (https://github.com/Slattz/LibACNH).
+ *
+ * LibACNH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LibACNH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LibACNH.  If not, see <https://www.gnu.org/licenses/>
+ */
+
+#include "ACNHByaml.hpp"
+#include "MurmurHash3.hpp"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Reads a list of dotted field paths and one or more save layout .byml files, and writes a header of
+ * constexpr SaveLayoutField tables (see SaveLayout.hpp), one namespace per layout.
+ */
+
+static void PrintUsage(const char* name) {
+    printf("Usage: %s <out.hpp> <paths.txt> <rootType> <namespace>=<layout.byml> [<namespace>=<layout.byml> ...]\n", name);
+    printf("  paths.txt    One dotted path per line (e.g. Player.Pocket1), '#' starts a comment\n");
+    printf("  rootType     Type name of the save root, hashed with MurmurHash3 (or a 0x hash)\n");
+    printf("  Path components are member names, also hashed with MurmurHash3 unless given as 0x hashes\n");
+}
+
+static u32 HashName(const std::string& name) {
+    if (name.size() > 2 && name[0] == '0' && (name[1] == 'x' || name[1] == 'X'))
+        return static_cast<u32>(strtoul(name.c_str(), nullptr, 16));
+
+    return MurmurHash3::Calc(reinterpret_cast<u8*>(const_cast<char*>(name.c_str())), 0, static_cast<u32>(name.size()));
+}
+
+static bool IsIdentifier(const std::string& name) {
+    if (name.empty() || isdigit(static_cast<unsigned char>(name[0])))
+        return false;
+
+    for (char c : name) {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '_')
+            return false;
+    }
+    return true;
+}
+
+static bool ReadPaths(const char* filePath, std::vector<std::string>& outPaths) {
+    FILE* file = fopen(filePath, "r");
+    if (file == NULL)
+        return false;
+
+    char chunk[0x400];
+    std::string path;
+    while (fgets(chunk, sizeof(chunk), file) != NULL) {
+        path += chunk;
+        if (path.back() != '\n' && !feof(file)) //Longer than the chunk, keep reading the line
+            continue;
+
+        size_t comment = path.find('#');
+        if (comment != std::string::npos)
+            path.erase(comment);
+
+        size_t begin = path.find_first_not_of(" \t\r\n");
+        size_t end = path.find_last_not_of(" \t\r\n");
+        if (begin != std::string::npos)
+            outPaths.push_back(path.substr(begin, end - begin + 1));
+        path.clear();
+    }
+
+    fclose(file);
+    return true;
+}
+
+//Same walk as ACNHByaml::CalcOffsets, but a missing component is reported instead of skipped
+static bool ResolvePath(const ACNHByaml& layout, u32 rootType, const std::string& path, u64& outOffset, u64& outSize) {
+    u32 typeName = rootType;
+    u64 offset = 0, size = 0;
+    size_t pos = 0;
+    while (pos <= path.size()) {
+        size_t end = path.find('.', pos);
+        if (end == std::string::npos)
+            end = path.size();
+
+        ACNHByamlMember member;
+        if (!layout.GetMember(typeName, HashName(path.substr(pos, end - pos)), member))
+            return false;
+
+        offset += member.offset;
+        size = member.size;
+        typeName = member.memberTypeName;
+        pos = end + 1;
+    }
+
+    outOffset = offset;
+    outSize = size;
+    return true;
+}
+
+//As the contents of a C string literal
+static void AppendEscaped(std::string& out, const std::string& str) {
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20 || c == 0x7F) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\%03o", static_cast<unsigned char>(c)); //Octal stops after 3 digits, unlike \x
+            out += escape;
+        }
+        else {
+            out += c;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 5) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> paths;
+    if (!ReadPaths(argv[2], paths)) {
+        fprintf(stderr, "Failed to read %s\n", argv[2]);
+        return 1;
+    }
+
+    u32 rootType = HashName(argv[3]);
+    std::string out;
+    out += "//Generated by acnh_layoutgen, do not edit\n";
+    out += "#pragma once\n";
+    out += "#include \"SaveLayout.hpp\"\n";
+
+    char numbers[0x40];
+    for (int i = 4; i < argc; i++) {
+        const char* split = strchr(argv[i], '=');
+        std::string name = split ? std::string(argv[i], split - argv[i]) : "";
+        if (!IsIdentifier(name)) {
+            fprintf(stderr, "Invalid layout argument '%s', expected <namespace>=<layout.byml>\n", argv[i]);
+            return 1;
+        }
+
+        ACNHByaml layout(split + 1, true);
+        if (!layout.IsValid() || layout.GetMemberCount() == 0) {
+            fprintf(stderr, "%s: %s\n", split + 1, layout.IsValid() ? "No types found" : layout.GetErrorMessage());
+            return 1;
+        }
+
+        out += "\nnamespace SaveLayout {\n";
+        out += "    namespace " + name + " {\n";
+        out += "        static const constexpr SaveLayoutField Fields[] = {\n";
+        u32 resolved = 0;
+        for (const std::string& path : paths) {
+            u64 offset = 0, size = 0;
+            if (!ResolvePath(layout, rootType, path, offset, size)) {
+                fprintf(stderr, "%s: '%s' not found, skipped\n", name.c_str(), path.c_str());
+                continue;
+            }
+
+            out += "            { \"";
+            AppendEscaped(out, path);
+            snprintf(numbers, sizeof(numbers), "\", 0x%llX, 0x%llX },\n",
+                static_cast<unsigned long long>(offset), static_cast<unsigned long long>(size));
+            out += numbers;
+            resolved++;
+        }
+
+        if (resolved == 0)
+            out += "            { \"\", 0, 0 }, //No paths resolved\n";
+        out += "        };\n";
+        out += "\n";
+        out += "#if __cplusplus > 201703L\n";
+        out += "        template <SaveLayout::Path path> consteval u64 Offset() { return SaveLayout::GetOffset<path>(Fields); }\n";
+        out += "        template <SaveLayout::Path path> consteval u64 Size() { return SaveLayout::GetSize<path>(Fields); }\n";
+        out += "#endif\n";
+        out += "    }\n";
+        out += "}\n";
+        printf("%s: %u/%zu paths\n", name.c_str(), resolved, paths.size());
+    }
+
+    FILE* file = fopen(argv[1], "w");
+    if (file == NULL || fwrite(out.data(), sizeof(char), out.size(), file) != out.size()) {
+        fprintf(stderr, "Failed to write %s\n", argv[1]);
+        if (file != NULL)
+            fclose(file);
+        return 1;
+    }
+    fclose(file);
+    return 0;
+}